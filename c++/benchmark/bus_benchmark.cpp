@@ -0,0 +1,342 @@
+//
+// *********     Bus Transaction Benchmark      *********
+//
+//
+// Times complete bus transactions through the SDK, end to end as a control loop sees them:
+//   ping            PacketHandler::ping to the first ID
+//   read4           read4ByteTxRx of Present Position from the first ID
+//   sync_read       GroupSyncRead::txRxPacket, Present Position of every ID
+//   fast_sync_read  GroupFastSyncRead::txRxPacket, same data in one status packet
+//   bulk_read       GroupBulkRead::txRxPacket, same data
+//   sync_write      GroupSyncWrite::txPacket of Goal Position to every ID (no status packets,
+//                   so this is only the time to hand the packet to the driver)
+//
+// Without --port the servos are the dxl_simulator chain on a pty, swept over --bauds and
+// --counts; its wire timing is modelled, so results show protocol cost, not USB adapter cost.
+// With --port it runs once against real servos at --baud with --ids.
+//
+// Usage: bus_benchmark [--iterations N] [--bauds B1,B2,...] [--counts N1,N2,...] [--return-delay-us US]
+//        bus_benchmark --port /dev/ttyUSB0 [--baud BPS] [--ids FIRST-LAST] [--iterations N]
+//
+// Per transaction: p50/p99/p99.9 wall latency, transactions/s and CPU time of the calling thread.
+// The p50 latency is then split with the PortHandlerLinux transaction timestamps into
+// request to first response byte (wire time, return delay, USB latency), first to last
+// response byte, and last byte to the call returning (host processing).
+//
+// The simulator hands each status packet to the pty whole, once its servo has finished sending
+// it. A packet's own wire time therefore counts towards the first byte, and fast_sync_read,
+// whose one status packet every servo appends to in turn, shows nearly all of its time there.
+// For the transactions with one status packet per servo the split is meaningful.
+//
+// Default sweep against the simulator (500 us Return Delay, 200 iterations), 12 servos:
+//
+//        baud  transaction      p50 us     tx/s  1st rx us    rx us  host us
+//       57600  read4            5757.2    164.7     5672.3     69.7      1.8
+//       57600  sync_read       41978.8     23.7     7757.3  34209.8      2.2
+//       57600  fast_sync_read  23387.5     41.8    23287.6     73.5      3.8
+//       57600  bulk_read       49624.3     20.0    15438.6  34175.7      2.2
+//     1000000  read4             960.6   1032.6      890.9     64.2      1.3
+//     1000000  sync_read        8225.8    121.3     1010.4   7207.6      1.3
+//     1000000  fast_sync_read   1985.3    497.8     1911.4     64.6      1.6
+//     1000000  bulk_read        8678.7    114.4     1468.4   7206.4      1.5
+//     4000000  read4             729.6   1277.0      662.1     62.9      0.9
+//     4000000  sync_read        6681.7    148.9      699.3   5975.4      1.3
+//     4000000  fast_sync_read    992.4   1006.0      921.8     63.5      1.3
+//     4000000  bulk_read        6798.5    141.6      813.5   5975.1      1.2
+//
+// Twelve Return Delays dominate sync_read and bulk_read at 1 Mbps and above; fast_sync_read
+// pays one. Lowering the Return Delay Time (bus_config) matters more than the baud rate there.
+//
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "dynamixel_sdk.h"                                  // Uses Dynamixel SDK library
+#include "port_handler_linux.h"
+#include "dxl_simulator.h"
+
+// Control table address
+#define ADDR_PRO_TORQUE_ENABLE          64
+#define ADDR_PRO_GOAL_POSITION          116
+#define ADDR_PRO_PRESENT_POSITION       132
+
+// Data Byte Length
+#define LEN_PRO_PRESENT_POSITION        4
+
+// Protocol version
+#define PROTOCOL_VERSION                2.0
+
+#define DEFAULT_ITERATIONS              200
+
+enum Transaction
+{
+  TX_PING,
+  TX_READ4,
+  TX_SYNC_READ,
+  TX_FAST_SYNC_READ,
+  TX_BULK_READ,
+  TX_SYNC_WRITE,
+  TX_COUNT
+};
+
+static const char *TRANSACTION_NAMES[TX_COUNT] = { "ping", "read4", "sync_read", "fast_sync_read", "bulk_read", "sync_write" };
+
+struct Result
+{
+  double p50_us;
+  double p99_us;
+  double p999_us;
+  double per_second;
+  double cpu_us;
+  double first_byte_us;                                     // p50 of each part of a transaction
+  double receive_us;
+  double host_us;
+  int    failures;
+};
+
+static int64_t getTimeNs(clockid_t clock)
+{
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int baudIndex(int baudrate)
+{
+  static const int baudrates[] = { 9600, 57600, 115200, 1000000, 2000000, 3000000, 4000000, 4500000 };
+  for (int i = 0; i < 8; i++)
+  {
+    if (baudrates[i] == baudrate)
+      return i;
+  }
+  return -1;
+}
+
+static std::vector<int> parseList(const char *text)
+{
+  std::vector<int> values;
+  for (const char *p = text; p && *p; p = strchr(p, ','), p = p ? p + 1 : NULL)
+    values.push_back(atoi(p));
+  return values;
+}
+
+static double percentile(const std::vector<int64_t> &sorted, double fraction)
+{
+  size_t index = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+  return sorted[index] / 1000.0;
+}
+
+// Runs one transaction type `iterations` times against servos first_id..last_id
+static Result runTransaction(Transaction type, dynamixel::PortHandler *portHandler, dynamixel::PacketHandler *packetHandler,
+                             int first_id, int last_id, int iterations)
+{
+  dynamixel::GroupSyncRead groupSyncRead(portHandler, packetHandler, ADDR_PRO_PRESENT_POSITION, LEN_PRO_PRESENT_POSITION);
+  dynamixel::GroupFastSyncRead groupFastSyncRead(portHandler, packetHandler, ADDR_PRO_PRESENT_POSITION, LEN_PRO_PRESENT_POSITION);
+  dynamixel::GroupBulkRead groupBulkRead(portHandler, packetHandler);
+  dynamixel::GroupSyncWrite groupSyncWrite(portHandler, packetHandler, ADDR_PRO_GOAL_POSITION, LEN_PRO_PRESENT_POSITION);
+
+  for (int id = first_id; id <= last_id; id++)
+  {
+    uint8_t goal[4] = { DXL_LOBYTE(DXL_LOWORD(2048)), DXL_HIBYTE(DXL_LOWORD(2048)), 0, 0 };
+    groupSyncRead.addParam(id);
+    groupFastSyncRead.addParam(id);
+    groupBulkRead.addParam(id, ADDR_PRO_PRESENT_POSITION, LEN_PRO_PRESENT_POSITION);
+    groupSyncWrite.addParam(id, goal);
+  }
+
+  // Linux only: the port records when the request went out and the response came in
+  dynamixel::PortHandlerLinux *linuxPort = dynamic_cast<dynamixel::PortHandlerLinux *>(portHandler);
+
+  std::vector<int64_t> samples, first_byte, receive, host;
+  samples.reserve(iterations);
+  Result result;
+  memset(&result, 0, sizeof(result));
+
+  int64_t cpu_start = getTimeNs(CLOCK_THREAD_CPUTIME_ID);
+  int64_t wall_start = getTimeNs(CLOCK_MONOTONIC);
+  for (int i = 0; i < iterations; i++)
+  {
+    uint8_t dxl_error = 0;
+    uint16_t model_number = 0;
+    uint32_t position = 0;
+    int dxl_comm_result = COMM_TX_FAIL;
+
+    int64_t start = getTimeNs(CLOCK_MONOTONIC);
+    switch (type)
+    {
+      case TX_PING:
+        dxl_comm_result = packetHandler->ping(portHandler, first_id, &model_number, &dxl_error);
+        break;
+      case TX_READ4:
+        dxl_comm_result = packetHandler->read4ByteTxRx(portHandler, first_id, ADDR_PRO_PRESENT_POSITION, &position, &dxl_error);
+        break;
+      case TX_SYNC_READ:
+        dxl_comm_result = groupSyncRead.txRxPacket();
+        break;
+      case TX_FAST_SYNC_READ:
+        dxl_comm_result = groupFastSyncRead.txRxPacket();
+        break;
+      case TX_BULK_READ:
+        dxl_comm_result = groupBulkRead.txRxPacket();
+        break;
+      case TX_SYNC_WRITE:
+        dxl_comm_result = groupSyncWrite.txPacket();
+        break;
+      default:
+        break;
+    }
+    samples.push_back(getTimeNs(CLOCK_MONOTONIC) - start);
+    if (dxl_comm_result != COMM_SUCCESS)
+      result.failures++;
+    else if (linuxPort != NULL && linuxPort->getFirstByteTime() != 0)
+    {
+      int64_t end = linuxPort->getCurrentTimeNs();
+      first_byte.push_back(linuxPort->getFirstByteTime() - linuxPort->getTxStartTime());
+      receive.push_back(linuxPort->getLastByteTime() - linuxPort->getFirstByteTime());
+      host.push_back(end - linuxPort->getLastByteTime());
+    }
+  }
+  int64_t wall_ns = getTimeNs(CLOCK_MONOTONIC) - wall_start;
+  int64_t cpu_ns = getTimeNs(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+
+  std::sort(samples.begin(), samples.end());
+  result.p50_us = percentile(samples, 0.50);
+  result.p99_us = percentile(samples, 0.99);
+  result.p999_us = percentile(samples, 0.999);
+  result.per_second = iterations * 1e9 / (double)wall_ns;
+  result.cpu_us = cpu_ns / 1000.0 / iterations;
+  if (!first_byte.empty())
+  {
+    std::sort(first_byte.begin(), first_byte.end());
+    std::sort(receive.begin(), receive.end());
+    std::sort(host.begin(), host.end());
+    result.first_byte_us = percentile(first_byte, 0.50);
+    result.receive_us = percentile(receive, 0.50);
+    result.host_us = percentile(host, 0.50);
+  }
+  return result;
+}
+
+static void runSuite(dynamixel::PortHandler *portHandler, int baudrate, int first_id, int last_id, int iterations)
+{
+  dynamixel::PacketHandler *packetHandler = dynamixel::PacketHandler::getPacketHandler(PROTOCOL_VERSION);
+
+  // Hold position so the reads see a torqued servo and the writes are accepted
+  for (int id = first_id; id <= last_id; id++)
+  {
+    uint8_t dxl_error = 0;
+    packetHandler->write1ByteTxRx(portHandler, id, ADDR_PRO_TORQUE_ENABLE, 1, &dxl_error);
+  }
+
+  for (int t = 0; t < TX_COUNT; t++)
+  {
+    Result r = runTransaction((Transaction)t, portHandler, packetHandler, first_id, last_id, iterations);
+    printf("%9d %7d  %-15s %10.1f %10.1f %10.1f %10.1f %9.1f %6d %10.1f %10.1f %9.1f\n", baudrate, last_id - first_id + 1,
+           TRANSACTION_NAMES[t], r.p50_us, r.p99_us, r.p999_us, r.per_second, r.cpu_us, r.failures,
+           r.first_byte_us, r.receive_us, r.host_us);
+    fflush(stdout);
+  }
+
+  for (int id = first_id; id <= last_id; id++)
+  {
+    uint8_t dxl_error = 0;
+    packetHandler->write1ByteTxRx(portHandler, id, ADDR_PRO_TORQUE_ENABLE, 0, &dxl_error);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  const char *port_name = NULL;
+  int baudrate = 57600;
+  int first_id = 1, last_id = 12;
+  int iterations = DEFAULT_ITERATIONS;
+  int return_delay_us = 500;
+  std::vector<int> bauds = parseList("57600,1000000,4000000");
+  std::vector<int> counts = parseList("1,4,12");
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+    if (value == NULL)
+    {
+      printf("Missing value for %s\n", argv[i]);
+      return 1;
+    }
+    if (strcmp(argv[i], "--port") == 0)
+      port_name = value;
+    else if (strcmp(argv[i], "--baud") == 0)
+      baudrate = atoi(value);
+    else if (strcmp(argv[i], "--ids") == 0)
+      sscanf(value, "%d-%d", &first_id, &last_id);
+    else if (strcmp(argv[i], "--iterations") == 0)
+      iterations = atoi(value);
+    else if (strcmp(argv[i], "--bauds") == 0)
+      bauds = parseList(value);
+    else if (strcmp(argv[i], "--counts") == 0)
+      counts = parseList(value);
+    else if (strcmp(argv[i], "--return-delay-us") == 0)
+      return_delay_us = atoi(value);
+    else
+    {
+      printf("Unknown option %s\n", argv[i]);
+      return 1;
+    }
+    i++;
+  }
+  if (iterations < 1)
+    iterations = DEFAULT_ITERATIONS;
+
+  printf("%9s %7s  %-15s %10s %10s %10s %10s %9s %6s %10s %10s %9s\n", "baud", "servos", "transaction",
+         "p50 us", "p99 us", "p99.9 us", "tx/s", "cpu us", "fail", "1st rx us", "rx us", "host us");
+
+  if (port_name != NULL)
+  {
+    dynamixel::PortHandler *portHandler = dynamixel::PortHandler::getPortHandler(port_name);
+    if (!portHandler->openPort() || !portHandler->setBaudRate(baudrate))
+    {
+      printf("Failed to open %s at %d\n", port_name, baudrate);
+      return 1;
+    }
+    runSuite(portHandler, baudrate, first_id, last_id, iterations);
+    portHandler->closePort();
+    return 0;
+  }
+
+  for (size_t b = 0; b < bauds.size(); b++)
+  {
+    if (baudIndex(bauds[b]) < 0)
+    {
+      printf("Unsupported baud rate %d\n", bauds[b]);
+      return 1;
+    }
+    for (size_t c = 0; c < counts.size(); c++)
+    {
+      SimOptions options;
+      options.first_id = 1;
+      options.last_id = counts[c];
+      options.baud_index = baudIndex(bauds[b]);
+      options.return_delay = (uint8_t)(return_delay_us / 2);
+
+      DxlSimulator simulator(options);
+      if (!simulator.open(NULL) || !simulator.start())
+        return 1;
+
+      dynamixel::PortHandler *portHandler = dynamixel::PortHandler::getPortHandler(simulator.getPortName());
+      if (!portHandler->openPort() || !portHandler->setBaudRate(bauds[b]))
+      {
+        printf("Failed to open %s\n", simulator.getPortName());
+        return 1;
+      }
+      runSuite(portHandler, bauds[b], options.first_id, options.last_id, iterations);
+      portHandler->closePort();
+      delete portHandler;
+      simulator.stop();
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,103 @@
+//
+// *********     CRC-16 Micro-benchmark      *********
+//
+//
+// Compares Protocol2PacketHandler::updateCRC (slicing-by-8) with the byte-at-a-time
+// table lookup it replaced, over packet sizes seen on the bus:
+//   14 bytes    ping / read status packet
+//   56 bytes    SyncWrite of goal positions to 12 servos
+//   104 bytes   FastSyncRead response from 12 servos (4 bytes each)
+//   1024 bytes  largest Protocol 2.0 packet
+// No Dynamixel is needed to run it.
+//
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "dynamixel_sdk.h"                                  // Uses Dynamixel SDK library
+#include "protocol2_packet_handler.h"
+
+#define ITERATION_BYTES                 (64 * 1024 * 1024)  // Bytes hashed per measurement
+
+static uint16_t bytewise_table[256];
+
+// The byte-at-a-time CRC-16 (polynomial 0x8005) used before slicing-by-8
+uint16_t bytewiseCRC(uint16_t crc_accum, uint8_t *data_blk_ptr, uint16_t data_blk_size)
+{
+  uint16_t i;
+
+  for (uint16_t j = 0; j < data_blk_size; j++)
+  {
+    i = ((uint16_t)(crc_accum >> 8) ^ *data_blk_ptr++) & 0xFF;
+    crc_accum = (crc_accum << 8) ^ bytewise_table[i];
+  }
+
+  return crc_accum;
+}
+
+void buildBytewiseTable()
+{
+  for (int b = 0; b < 256; b++)
+  {
+    uint16_t crc = b << 8;
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x8005 : (crc << 1);
+    bytewise_table[b] = crc;
+  }
+}
+
+double getTimeNs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+int main()
+{
+  dynamixel::Protocol2PacketHandler *packetHandler = dynamixel::Protocol2PacketHandler::getInstance();
+
+  uint8_t packet[1024];
+  const uint16_t sizes[] = { 14, 56, 104, 1024 };
+
+  buildBytewiseTable();
+
+  srand(1);
+  for (int i = 0; i < (int)sizeof(packet); i++)
+    packet[i] = rand() & 0xFF;
+
+  // Both implementations must agree on every length and starting CRC
+  for (uint16_t length = 0; length <= sizeof(packet); length++)
+  {
+    uint16_t seed = length * 0x9E37;
+    if (bytewiseCRC(seed, packet, length) != packetHandler->updateCRC(seed, packet, length))
+    {
+      printf("[CRC16] Mismatch at length %d\n", length);
+      return 1;
+    }
+  }
+  printf("[CRC16] Results match for lengths 0 - %d\n\n", (int)sizeof(packet));
+
+  printf("%10s %18s %18s %10s\n", "bytes", "byte-wise ns/pkt", "slicing-8 ns/pkt", "speedup");
+  for (unsigned int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+  {
+    uint16_t length = sizes[s];
+    long loops = ITERATION_BYTES / length;
+    volatile uint16_t sink = 0;
+
+    double start = getTimeNs();
+    for (long l = 0; l < loops; l++)
+      sink = bytewiseCRC(sink, packet, length);
+    double bytewise_ns = (getTimeNs() - start) / loops;
+
+    start = getTimeNs();
+    for (long l = 0; l < loops; l++)
+      sink = packetHandler->updateCRC(sink, packet, length);
+    double slicing_ns = (getTimeNs() - start) / loops;
+
+    printf("%10d %18.1f %18.1f %9.2fx\n", length, bytewise_ns, slicing_ns, bytewise_ns / slicing_ns);
+  }
+
+  return 0;
+}
@@ -0,0 +1,257 @@
+//
+// *********     Bus Configuration Tool      *********
+//
+//
+// Finds every servo on the chain whatever its baud rate, then moves the whole chain and the
+// host port to one target baud rate with a short Return Delay Time, and checks the result.
+//   1. Scan: broadcast ping at each X series baud rate (57600 first, the factory default)
+//   2. Switch: torque off, write Return Delay Time and then Baud Rate at each servo's old baud;
+//      the servo answers at the old rate and changes after the reply
+//   3. Verify: at the target baud every servo found must answer a ping and read back the new
+//      Return Delay Time; servos whose switch failed are reported by ID and not verified
+//
+// Usage: bus_config [--port DEVICE] [--baud BPS] [--return-delay-us US] [--scan]
+//   --baud             Target rate: 9600, 57600, 115200, 1000000, 2000000, 3000000, 4000000, 4500000
+//                      (default 1000000; the U2D2 handles 4000000, other adapters may stop at 3000000)
+//   --return-delay-us  0 - 508 in 2 us steps (default 0)
+//   --scan             Only list the servos and their baud rates
+//
+// The Baud Rate and Return Delay Time registers are in EEPROM, so they survive power cycles.
+// Run the control programs with the same rate afterwards (e.g. ./sync_read_write 1000000).
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "dynamixel_sdk.h"                                  // Uses Dynamixel SDK library
+
+// Control table address
+#define ADDR_PRO_BAUD_RATE              8
+#define ADDR_PRO_RETURN_DELAY_TIME      9
+#define ADDR_PRO_TORQUE_ENABLE          64
+
+// Protocol version
+#define PROTOCOL_VERSION                2.0
+
+// Default setting
+#define DEVICENAME                      "/dev/ttyUSB0"
+#define TARGET_BAUDRATE                 1000000
+
+#define TORQUE_DISABLE                  0
+
+// Baud Rate register value -> bits per second
+static const int BAUD_RATES[] = { 9600, 57600, 115200, 1000000, 2000000, 3000000, 4000000, 4500000 };
+#define NUM_BAUD_RATES                  8
+
+// Most likely rates first, so a chain at the factory default is found quickly
+static const int SCAN_ORDER[] = { 57600, 1000000, 4000000, 2000000, 3000000, 115200, 4500000, 9600 };
+
+struct FoundServo
+{
+  uint8_t id;
+  int     baudrate;
+};
+
+int baudRegisterValue(int baudrate)
+{
+  for (int i = 0; i < NUM_BAUD_RATES; i++)
+  {
+    if (BAUD_RATES[i] == baudrate)
+      return i;
+  }
+  return -1;
+}
+
+std::vector<FoundServo> scanBus(dynamixel::PortHandler *portHandler, dynamixel::PacketHandler *packetHandler)
+{
+  std::vector<FoundServo> found;
+  std::vector<bool> seen(256, false);
+
+  for (int i = 0; i < NUM_BAUD_RATES; i++)
+  {
+    int baudrate = SCAN_ORDER[i];
+    if (!portHandler->setBaudRate(baudrate))
+    {
+      printf("[%7d] Port does not support this rate, skipped\n", baudrate);
+      continue;
+    }
+
+    std::vector<uint8_t> ids;
+    packetHandler->broadcastPing(portHandler, ids);
+    for (size_t j = 0; j < ids.size(); j++)
+    {
+      if (seen[ids[j]])
+        continue;     // Garbled echo of a servo already found at another rate
+      seen[ids[j]] = true;
+      FoundServo servo = { ids[j], baudrate };
+      found.push_back(servo);
+    }
+    printf("[%7d] %d servo(s)\n", baudrate, (int)ids.size());
+  }
+  return found;
+}
+
+bool switchServo(dynamixel::PortHandler *portHandler, dynamixel::PacketHandler *packetHandler,
+                 const FoundServo &servo, int target_baudrate, uint8_t return_delay)
+{
+  uint8_t dxl_error = 0;
+  int dxl_comm_result;
+
+  // EEPROM registers are only writable with torque off
+  dxl_comm_result = packetHandler->write1ByteTxRx(portHandler, servo.id, ADDR_PRO_TORQUE_ENABLE, TORQUE_DISABLE, &dxl_error);
+  if (dxl_comm_result != COMM_SUCCESS || dxl_error != 0)
+  {
+    printf("[ID:%03d] Torque off failed: %s\n", servo.id, dxl_comm_result != COMM_SUCCESS ?
+           packetHandler->getTxRxResult(dxl_comm_result) : packetHandler->getRxPacketError(dxl_error));
+    return false;
+  }
+
+  dxl_comm_result = packetHandler->write1ByteTxRx(portHandler, servo.id, ADDR_PRO_RETURN_DELAY_TIME, return_delay, &dxl_error);
+  if (dxl_comm_result != COMM_SUCCESS || dxl_error != 0)
+  {
+    printf("[ID:%03d] Return Delay Time write failed\n", servo.id);
+    return false;
+  }
+
+  if (servo.baudrate != target_baudrate)
+  {
+    // The reply may already be lost to the switch; the verify pass decides
+    packetHandler->write1ByteTxRx(portHandler, servo.id, ADDR_PRO_BAUD_RATE, baudRegisterValue(target_baudrate), &dxl_error);
+  }
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  const char *port_name = DEVICENAME;
+  int target_baudrate = TARGET_BAUDRATE;
+  int return_delay_us = 0;
+  bool scan_only = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--scan") == 0)
+      scan_only = true;
+    else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+      port_name = argv[++i];
+    else if (strcmp(argv[i], "--baud") == 0 && i + 1 < argc)
+      target_baudrate = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--return-delay-us") == 0 && i + 1 < argc)
+      return_delay_us = atoi(argv[++i]);
+    else
+    {
+      printf("Usage: %s [--port DEVICE] [--baud BPS] [--return-delay-us US] [--scan]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (baudRegisterValue(target_baudrate) < 0)
+  {
+    printf("%d is not an X series baud rate\n", target_baudrate);
+    return 1;
+  }
+  if (return_delay_us < 0 || return_delay_us > 508)
+  {
+    printf("Return delay must be 0 - 508 us\n");
+    return 1;
+  }
+  uint8_t return_delay = (uint8_t)(return_delay_us / 2);
+
+  dynamixel::PortHandler *portHandler = dynamixel::PortHandler::getPortHandler(port_name);
+  dynamixel::PacketHandler *packetHandler = dynamixel::PacketHandler::getPacketHandler(PROTOCOL_VERSION);
+  if (!portHandler->openPort())
+  {
+    printf("Failed to open %s\n", port_name);
+    return 1;
+  }
+
+  // 1. Scan
+  printf("Scanning %s\n", port_name);
+  std::vector<FoundServo> servos = scanBus(portHandler, packetHandler);
+  if (servos.empty())
+  {
+    printf("No servos found\n");
+    portHandler->closePort();
+    return 1;
+  }
+  for (size_t i = 0; i < servos.size(); i++)
+    printf("[ID:%03d] %d bps\n", servos[i].id, servos[i].baudrate);
+  if (scan_only)
+  {
+    portHandler->closePort();
+    return 0;
+  }
+
+  // 2. Switch, one port baud change per group of servos
+  std::vector<int> done;
+  std::vector<bool> switched(servos.size(), false);
+  for (size_t i = 0; i < servos.size(); i++)
+  {
+    if (std::find(done.begin(), done.end(), servos[i].baudrate) != done.end())
+      continue;
+    done.push_back(servos[i].baudrate);
+    if (!portHandler->setBaudRate(servos[i].baudrate))
+    {
+      printf("Failed to set the port to %d bps, servos at that rate are left as they are\n", servos[i].baudrate);
+      continue;
+    }
+
+    for (size_t j = i; j < servos.size(); j++)
+    {
+      if (servos[j].baudrate == servos[i].baudrate)
+        switched[j] = switchServo(portHandler, packetHandler, servos[j], target_baudrate, return_delay);
+    }
+  }
+
+  // 3. Verify at the target rate
+  if (!portHandler->setBaudRate(target_baudrate))
+  {
+    printf("Failed to set the port to %d bps\n", target_baudrate);
+    portHandler->closePort();
+    return 1;
+  }
+
+  int failures = 0;
+  std::vector<uint8_t> not_switched;
+  for (size_t i = 0; i < servos.size(); i++)
+  {
+    if (!switched[i])
+    {
+      // Still at its old baud rate; pinging it at the target would only time out
+      not_switched.push_back(servos[i].id);
+      failures++;
+      continue;
+    }
+
+    uint8_t dxl_error = 0;
+    uint8_t value = 0xFF;
+    uint16_t model_number = 0;
+    int dxl_comm_result = packetHandler->ping(portHandler, servos[i].id, &model_number, &dxl_error);
+    if (dxl_comm_result == COMM_SUCCESS)
+      dxl_comm_result = packetHandler->read1ByteTxRx(portHandler, servos[i].id, ADDR_PRO_RETURN_DELAY_TIME, &value, &dxl_error);
+
+    if (dxl_comm_result != COMM_SUCCESS || value != return_delay)
+    {
+      printf("[ID:%03d] FAILED: %s\n", servos[i].id, dxl_comm_result != COMM_SUCCESS ?
+             packetHandler->getTxRxResult(dxl_comm_result) : "Return Delay Time did not change");
+      failures++;
+    }
+    else
+    {
+      printf("[ID:%03d] model %d, %d bps, return delay %d us\n", servos[i].id, model_number, target_baudrate, value * 2);
+    }
+  }
+
+  portHandler->closePort();
+  printf("%d of %d servo(s) at %d bps\n", (int)servos.size() - failures, (int)servos.size(), target_baudrate);
+  if (!not_switched.empty())
+  {
+    printf("Not switched, left at their old baud rate:");
+    for (size_t i = 0; i < not_switched.size(); i++)
+      printf(" %d", not_switched[i]);
+    printf("\n");
+  }
+  return failures == 0 ? 0 : 1;
+}
@@ -3,6 +3,7 @@
 #include <cstdlib>
 #include <cstdint>
 #include <cstring>
+#include <algorithm>
 #include <cmath>
 #include <ctime>
 #include <iomanip>
@@ -30,6 +31,7 @@
 
 // === Dynamixel SDK ===
 #include "dynamixel_sdk.h"  // Uses Dynamixel SDK library
+#include "imu_roll.h"
 
 // === Macro Definitions ===
 
@@ -46,7 +48,7 @@
 #define PROTOCOL_VERSION                2.0
 
 // Default settings
-#define BAUDRATE                        57600
+#define BAUDRATE                        57600               // Default; pass another rate as the first argument after bus_config
 #define DEVICENAME                      "/dev/ttyUSB0"
 
 #define TORQUE_ENABLE                   1
@@ -82,13 +84,6 @@ int read_register(int file, uint8_t reg) {
     return data;
 }
 
-int16_t read_16bit_register(int file, uint8_t reg_low, uint8_t reg_high) {
-    int16_t low = read_register(file, reg_low);
-    int16_t high = read_register(file, reg_high);
-    if (low == -1 || high == -1) return -1;
-    return (high << 8) | low;
-}
-
 int DXL_ID;
 int present_positions[NUM_MOTORS + 1] = {0};
 
@@ -203,9 +198,7 @@ void move_to(
           dynamixel::PacketHandler *packetHandler,
           dynamixel::GroupSyncRead &groupSyncRead,
           dynamixel::PortHandler *portHandler) {
-  // Clear previous SyncWrite parameters
-  groupSyncWrite.clearParam();
-
+  // The SyncWrite parameters stay listed between calls; only the goal positions change
   for (int id = 1; id <= 12; id++) {
       uint8_t param_goal_position[4];
       int goal_position = positions[id];
@@ -215,8 +208,9 @@ void move_to(
       param_goal_position[2] = DXL_LOBYTE(DXL_HIWORD(goal_position));
       param_goal_position[3] = DXL_HIBYTE(DXL_HIWORD(goal_position));
 
-      // Add goal position to SyncWrite buffer
-      if (!groupSyncWrite.addParam(id, param_goal_position)) {
+      // Overwrite the goal position in place, or add it the first time
+      if (!groupSyncWrite.changeParam(id, param_goal_position) &&
+          !groupSyncWrite.addParam(id, param_goal_position)) {
           fprintf(stderr, "[ID:%03d] groupSyncWrite addParam failed\n", id);
           continue;
       }
@@ -227,9 +221,6 @@ void move_to(
       printf("%s\n", packetHandler->getTxRxResult(dxl_comm_result));
   }
 
-  // Clear SyncWrite buffer after sending data
-  groupSyncWrite.clearParam();
-
   std::this_thread::sleep_for(std::chrono::milliseconds(10));  // Allow time for motors to reach the position
   update_present_positions(groupSyncRead, packetHandler, portHandler);
 }
@@ -243,7 +234,24 @@ std::string get_random_command() {
     return dist(gen) ? "rfy" : "rfb"; // Return "rfy" if 1, "rfb" if 0
 }
 
-int main() {
+// Baud rates an X series servo can be set to, as in bus_config
+bool is_servo_baudrate(int baudrate) {
+  static const int baud_rates[] = { 9600, 57600, 115200, 1000000, 2000000, 3000000, 4000000, 4500000 };
+  for (int rate : baud_rates) {
+    if (rate == baudrate)
+      return true;
+  }
+  return false;
+}
+
+int main(int argc, char *argv[]) {
+  int baudrate = (argc > 1) ? atoi(argv[1]) : BAUDRATE;  // e.g. 1000000 once bus_config has switched the chain
+  if (!is_servo_baudrate(baudrate)) {
+    printf("Usage: %s [BAUDRATE]\n", argv[0]);
+    printf("  BAUDRATE: 9600, 57600, 115200, 1000000, 2000000, 3000000, 4000000 or 4500000 (default %d)\n", BAUDRATE);
+    return 1;
+  }
+
   // Generate movement arrays for rolling
   generate_movement_arrays_roll_fw();
 
@@ -273,7 +281,7 @@ int main() {
   }
 
   // Set port baudrate
-  if (portHandler->setBaudRate(BAUDRATE)) {
+  if (portHandler->setBaudRate(baudrate)) {
     printf("Succeeded to change the baudrate!\n");
   } else {
     printf("Failed to change the baudrate!\n");
@@ -309,7 +317,7 @@ int main() {
     return 1;
   }
 
-  int addr = 0x6A; // LSM330DHCX I2C address
+  int addr = IMU_I2C_ADDRESS; // LSM330DHCX I2C address
   if (ioctl(file, I2C_SLAVE, addr) < 0) {
     std::cerr << "Failed to set I2C address\n";
     close(file);
@@ -319,6 +327,7 @@ int main() {
   // Enable gyroscope and accelerometer
   write_register(file, 0x10, 0x60); // Accelerometer
   write_register(file, 0x11, 0x60); // Gyroscope
+  write_register(file, IMU_REG_CTRL3_C, IMU_CTRL3_C_BDU_IF_INC); // Burst reads of consistent samples
   sleep(1); // Wait for sensor to initialize
 
   // Bias offsets for sensor calibration
@@ -330,25 +339,28 @@ int main() {
   // Thresholds and parameters for orientation detection
   const float accel_z_threshold = 9.5;    // m/s² for a successful propel
   const float gyro_y_stability = 6.5;     // rad/s threshold for orientation stability
-  const int window_size = 2;              // Number of samples to average (for smoothing)
-  
-  // Variables for data accumulation
-  float accumulated_tilt_angle = 0;
-  int sample_count = 0;
+
+  // Fused roll estimate, updated every sample
+  RollFilter roll_filter;
+  auto last_sample_time = std::chrono::steady_clock::now();
+  auto settled_time = last_sample_time + std::chrono::milliseconds(ROLL_SETTLE_MS);
   
   // Move to perfect circle configuration initially
   move_to(perfect_cir, groupSyncWrite, packetHandler, groupSyncRead, portHandler);
   
   while (true) {
-    // Read gyroscope data
-    int16_t gyro_x = read_16bit_register(file, 0x22, 0x23);
-    int16_t gyro_y = read_16bit_register(file, 0x24, 0x25);
-    int16_t gyro_z = read_16bit_register(file, 0x26, 0x27);
+    // Read gyroscope and accelerometer data in one burst
+    ImuSample sample;
+    if (read_imu_sample(file, &sample) != 0) {
+      continue;
+    }
+    int16_t gyro_x = sample.gyro_x;
+    int16_t gyro_y = sample.gyro_y;
+    int16_t gyro_z = sample.gyro_z;
 
-    // Read accelerometer data
-    int16_t accel_x = read_16bit_register(file, 0x28, 0x29);
-    int16_t accel_y = read_16bit_register(file, 0x2A, 0x2B);
-    int16_t accel_z = read_16bit_register(file, 0x2C, 0x2D);
+    int16_t accel_x = sample.accel_x;
+    int16_t accel_y = sample.accel_y;
+    int16_t accel_z = sample.accel_z;
 
     // Apply scale factors
     float gyro_dps_x = gyro_x * (250.0 / 32768.0);
@@ -359,50 +371,48 @@ int main() {
     float accel_mps2_y = accel_y * (2.0 / 32768.0) * 9.81;
     float accel_mps2_z = ((accel_z * (2.0 / 32768.0)) * 9.81) - accel_z_offset;
 
-    // Compute tilt angle around x-axis
-    float angle_rad = std::atan2(accel_mps2_y, accel_mps2_z);
-    float angle_degrees = angle_rad * (180.0 / M_PI);
-
-    // Accumulate data for smoothing
-    accumulated_tilt_angle += angle_degrees;
-    sample_count++;
-
-    // Check if enough samples have been collected
-    if (sample_count >= window_size) {
-      float avg_tilt_angle = accumulated_tilt_angle / sample_count;
-      std::cout << "Average Tilt Angle: " << avg_tilt_angle << " degrees" << std::endl;
-      
-      // Use tilt angle to determine which side is under
-      bool blue_under = (avg_tilt_angle >= -180 && avg_tilt_angle <= -122) ||
-                        (avg_tilt_angle >= 123 && avg_tilt_angle <= 180);
-      bool yellow_under = avg_tilt_angle >= -54 && avg_tilt_angle <= 58;
-
-      // Execute appropriate rolling action based on orientation
-      if (yellow_under) {
-        std::cout << "Yellow under – pushing yellow\n";
+    // Fuse the gyro roll rate with the gravity direction to get the tilt around the x-axis
+    auto sample_time = std::chrono::steady_clock::now();
+    float dt = std::chrono::duration<float>(sample_time - last_sample_time).count();
+    last_sample_time = sample_time;
+    roll_filter.update(gyro_dps_x, accel_mps2_x, accel_mps2_y, accel_mps2_z, 9.81f, dt);
+
+    // Let the filter run for a while after a push before acting on it again
+    if (dt > roll_filter.maxStepS()) {
+      settled_time = sample_time + std::chrono::milliseconds(ROLL_SETTLE_MS);
+    }
+    if (sample_time < settled_time) {
+      continue;
+    }
+
+    float tilt_angle = roll_filter.rollDegrees();
+    std::cout << "Tilt Angle: " << tilt_angle << " degrees, rate " << roll_filter.rateDps() << " deg/s" << std::endl;
+
+    // Use tilt angle to determine which side is under (the blue range wraps through 180)
+    bool blue_under = angleInRange(tilt_angle, 123, -122);
+    bool yellow_under = angleInRange(tilt_angle, -54, 58);
+
+    // Execute appropriate rolling action based on orientation
+    if (yellow_under) {
+      std::cout << "Yellow under – pushing yellow\n";
+      move_to(yellow_up_propel, groupSyncWrite, packetHandler, groupSyncRead, portHandler);
+      std::this_thread::sleep_for(std::chrono::milliseconds(700));
+      move_to(perfect_cir, groupSyncWrite, packetHandler, groupSyncRead, portHandler);
+    } else if (blue_under) {
+      std::cout << "Blue under – pushing blue\n";
+      move_to(blue_up_propel, groupSyncWrite, packetHandler, groupSyncRead, portHandler);
+      std::this_thread::sleep_for(std::chrono::milliseconds(700));
+      move_to(perfect_cir, groupSyncWrite, packetHandler, groupSyncRead, portHandler);
+    } else {
+      std::cout << "Unknown orientation. Executing random roll...\n";
+      std::string random_cmd = get_random_command();
+      if (random_cmd == "rfy") {
         move_to(yellow_up_propel, groupSyncWrite, packetHandler, groupSyncRead, portHandler);
-        std::this_thread::sleep_for(std::chrono::milliseconds(700));
-        move_to(perfect_cir, groupSyncWrite, packetHandler, groupSyncRead, portHandler);
-      } else if (blue_under) {
-        std::cout << "Blue under – pushing blue\n";
-        move_to(blue_up_propel, groupSyncWrite, packetHandler, groupSyncRead, portHandler);
-        std::this_thread::sleep_for(std::chrono::milliseconds(700));
-        move_to(perfect_cir, groupSyncWrite, packetHandler, groupSyncRead, portHandler);
       } else {
-        std::cout << "Unknown orientation. Executing random roll...\n";
-        std::string random_cmd = get_random_command();
-        if (random_cmd == "rfy") {
-          move_to(yellow_up_propel, groupSyncWrite, packetHandler, groupSyncRead, portHandler);
-        } else {
-          move_to(blue_up_propel, groupSyncWrite, packetHandler, groupSyncRead, portHandler);
-        }
-        std::this_thread::sleep_for(std::chrono::milliseconds(700));
-        move_to(perfect_cir, groupSyncWrite, packetHandler, groupSyncRead, portHandler);
+        move_to(blue_up_propel, groupSyncWrite, packetHandler, groupSyncRead, portHandler);
       }
-
-      // Reset accumulators
-      accumulated_tilt_angle = 0;
-      sample_count = 0;
+      std::this_thread::sleep_for(std::chrono::milliseconds(700));
+      move_to(perfect_cir, groupSyncWrite, packetHandler, groupSyncRead, portHandler);
     }
   }
 
@@ -0,0 +1,68 @@
+//
+// IMU access and roll estimate shared by the rolling programs
+//
+// The roll filter is the one the ROS node uses (orientation_filter.hpp), so the standalone
+// programs and the node cannot drift apart.
+//
+
+#ifndef CONTROL_IMU_ROLL_H_
+#define CONTROL_IMU_ROLL_H_
+
+#include <cstdint>
+#include <iostream>
+
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+
+#include "../../ros2_ws/src/quad_motor_control/include/quad_motor_control/orientation_filter.hpp"
+
+// IMU (LSM6-class, I2C_SLAVE address 0x6A)
+#define IMU_I2C_ADDRESS                 0x6A
+#define IMU_REG_CTRL3_C                 0x12
+#define IMU_REG_OUTX_L_G                0x22
+#define IMU_CTRL3_C_BDU_IF_INC          0x44                // Block data update + register auto-increment
+
+// A push stops sampling for longer than RollFilter integrates across, so the filter restarts from
+// the accelerometer alone; samples this soon after such a gap only feed the filter
+#define ROLL_SETTLE_MS                  200
+
+// One gyroscope + accelerometer reading in raw counts
+struct ImuSample {
+    int16_t gyro_x, gyro_y, gyro_z;
+    int16_t accel_x, accel_y, accel_z;
+};
+
+// Reads all six axes (OUTX_L_G 0x22 .. OUTZ_H_A 0x2D, 12 bytes) in one I2C_RDWR transaction:
+// register address write + repeated-start read, relying on the IMU's register auto-increment
+inline int read_imu_sample(int file, ImuSample* sample) {
+    uint8_t reg = IMU_REG_OUTX_L_G;
+    uint8_t data[12];
+    struct i2c_msg msgs[2];
+    msgs[0].addr = IMU_I2C_ADDRESS;
+    msgs[0].flags = 0;
+    msgs[0].len = 1;
+    msgs[0].buf = &reg;
+    msgs[1].addr = IMU_I2C_ADDRESS;
+    msgs[1].flags = I2C_M_RD;
+    msgs[1].len = sizeof(data);
+    msgs[1].buf = data;
+
+    struct i2c_rdwr_ioctl_data transfer;
+    transfer.msgs = msgs;
+    transfer.nmsgs = 2;
+    if (ioctl(file, I2C_RDWR, &transfer) != 2) {
+        std::cerr << "Failed to read IMU sample" << std::endl;
+        return -1;
+    }
+
+    sample->gyro_x  = (int16_t)(data[1] << 8 | data[0]);
+    sample->gyro_y  = (int16_t)(data[3] << 8 | data[2]);
+    sample->gyro_z  = (int16_t)(data[5] << 8 | data[4]);
+    sample->accel_x = (int16_t)(data[7] << 8 | data[6]);
+    sample->accel_y = (int16_t)(data[9] << 8 | data[8]);
+    sample->accel_z = (int16_t)(data[11] << 8 | data[10]);
+    return 0;
+}
+
+#endif // CONTROL_IMU_ROLL_H_
@@ -37,6 +37,7 @@
 #include <stdio.h>
 
 #include "dynamixel_sdk.h"                                  // Uses Dynamixel SDK library
+#include "../../ros2_ws/src/quad_motor_control/include/quad_motor_control/trajectory_profile.hpp"
 
 #include <string.h>
 #include <chrono>
@@ -65,7 +66,7 @@
 #define PROTOCOL_VERSION                2.0                 // See which protocol version is used in the Dynamixel
 
 // Default setting
-#define BAUDRATE                        57600
+#define BAUDRATE                        57600               // Default; pass another rate as the first argument after bus_config
 #define DEVICENAME                      "/dev/ttyUSB0"      // Check which port is being used on your controller
                                                             // ex) Windows: "COM1"   Linux: "/dev/ttyUSB0" Mac: "/dev/tty.usbserial-*"
 
@@ -79,6 +80,11 @@
 
 #define NUM_MOTORS                      12                  // IDs from 1 to 12
 
+// Gradual transition (minimum-jerk) joint limits, the quad_motor_control defaults
+#define TRANSITION_MAX_VELOCITY_DEG_S   270.0
+#define TRANSITION_MAX_ACCEL_DEG_S2     1800.0
+#define TRANSITION_STEP_MS              20                  // Goal update period
+
 
 int DXL_ID;
 bool toggle_position = false;  // Toggles between the two positions
@@ -874,9 +880,7 @@ void move_to(
           dynamixel::GroupSyncRead &groupSyncRead,
           dynamixel::PortHandler *portHandler) 
 {
-  // Clear previous SyncWrite parameters
-  groupSyncWrite.clearParam();
-
+  // The SyncWrite parameters stay listed between calls; only the goal positions change
   for (int id = 1; id <= 12; id++)  // Loop through motor IDs 1-12
   {
       uint8_t param_goal_position[4];
@@ -887,8 +891,9 @@ void move_to(
       param_goal_position[2] = DXL_LOBYTE(DXL_HIWORD(goal_position));
       param_goal_position[3] = DXL_HIBYTE(DXL_HIWORD(goal_position));
 
-      // Add goal position to SyncWrite buffer
-      if (!groupSyncWrite.addParam(id, param_goal_position)) {
+      // Overwrite the goal position in place, or add it the first time
+      if (!groupSyncWrite.changeParam(id, param_goal_position) &&
+          !groupSyncWrite.addParam(id, param_goal_position)) {
           fprintf(stderr, "[ID:%03d] groupSyncWrite addParam failed\n", id);
           continue;
       }
@@ -899,9 +904,6 @@ void move_to(
       printf("%s\n", packetHandler->getTxRxResult(dxl_comm_result));
   }
 
-  // Clear SyncWrite buffer after sending data
-  groupSyncWrite.clearParam();
-
   printf("All motors moved to goal position.\n");
   std::this_thread::sleep_for(std::chrono::milliseconds(10));  // Allow TIME for motors to reach the position
   update_present_positions(groupSyncRead, packetHandler, portHandler);
@@ -922,9 +924,7 @@ void move_to_target_positions(
 {
   printf("Moving motors to %s...\n", toggle_position ? "TOP RIGHT up" : "TOP LEFT up");
 
-  // Clear previous SyncWrite parameters
-  groupSyncWrite.clearParam();
-
+  // The SyncWrite parameters stay listed between calls; only the goal positions change
   for (int id = 1; id <= 12; id++)  // Loop through motor IDs 1-12
   {
       uint8_t param_goal_position[4];
@@ -935,8 +935,9 @@ void move_to_target_positions(
       param_goal_position[2] = DXL_LOBYTE(DXL_HIWORD(goal_position));
       param_goal_position[3] = DXL_HIBYTE(DXL_HIWORD(goal_position));
 
-      // Add goal position to SyncWrite buffer
-      if (!groupSyncWrite.addParam(id, param_goal_position)) {
+      // Overwrite the goal position in place, or add it the first time
+      if (!groupSyncWrite.changeParam(id, param_goal_position) &&
+          !groupSyncWrite.addParam(id, param_goal_position)) {
           fprintf(stderr, "[ID:%03d] groupSyncWrite addParam failed\n", id);
           continue;
       }
@@ -948,9 +949,6 @@ void move_to_target_positions(
       printf("%s\n", packetHandler->getTxRxResult(dxl_comm_result));
   }
 
-  // Clear SyncWrite buffer after sending data
-  groupSyncWrite.clearParam();
-
   printf("Motors moved to %s position.\n", toggle_position ? "TOP RIGHT up" : "TOP LEFT up");
 }
 
@@ -959,34 +957,66 @@ void gradual_transition(int* next_positions,
                          dynamixel::PacketHandler *packetHandler,
                          dynamixel::GroupSyncRead &groupSyncRead,  // Added parameter
                          dynamixel::PortHandler *portHandler) {  // Added parameter
-    const int step_size = 17;
-    float step_arr[NUM_MOTORS + 1] = {0};
-    int num_motors = NUM_MOTORS;
-
+    int start_positions[NUM_MOTORS + 1];
     int updated_positions[NUM_MOTORS + 1];
 
     // Ensure present_positions is updated before starting the transition
     update_present_positions(groupSyncRead, packetHandler, portHandler);
-    
-    std::copy(std::begin(present_positions), std::end(present_positions), std::begin(updated_positions));
 
-    for (int i = 1; i <= num_motors; i++) {
-        step_arr[i] = static_cast<float>(next_positions[i] - updated_positions[i]) / step_size;
+    std::copy(std::begin(present_positions), std::end(present_positions), std::begin(start_positions));
+
+    // Minimum-jerk move timed by the most constrained joint, so short moves finish sooner and
+    // every joint arrives together
+    JointLimits limits[NUM_MOTORS + 1];
+    for (int i = 0; i <= NUM_MOTORS; i++) {
+        limits[i] = JointLimits{(float)(TRANSITION_MAX_VELOCITY_DEG_S * TICKS_PER_DEGREE),
+                                (float)(TRANSITION_MAX_ACCEL_DEG_S2 * TICKS_PER_DEGREE)};
     }
+    TimeScaling scaling = TimeScaling::timeOptimal(ProfileType::MIN_JERK, start_positions, next_positions, limits);
+
+    auto start_time = std::chrono::steady_clock::now();
+    auto next_step = start_time;
+    while (true) {
+        next_step += std::chrono::milliseconds(TRANSITION_STEP_MS);
+        double t = std::chrono::duration<double>(next_step - start_time).count();
+        if (t >= scaling.duration) {
+            break;
+        }
 
-    for (int step = 0; step < step_size; step++) {
-        for (int i = 1; i <= num_motors; i++) {
-            updated_positions[i] += std::round(step_arr[i]);  // Fix rounding issue
+        double s = scaling.position((float)t);
+        for (int i = 1; i <= NUM_MOTORS; i++) {
+            // Interpolate from the start every step so rounding never accumulates
+            updated_positions[i] = start_positions[i] + (int)std::lround(s * (next_positions[i] - start_positions[i]));
         }
+        std::this_thread::sleep_until(next_step);
         move_to_target_positions(updated_positions, groupSyncWrite, packetHandler);
-        std::this_thread::sleep_for(std::chrono::milliseconds(20));
     }
 
     move_to_target_positions(next_positions, groupSyncWrite, packetHandler);
 }
 
-int main() 
+// Baud rates an X series servo can be set to, as in bus_config
+bool is_servo_baudrate(int baudrate)
 {
+  static const int baud_rates[] = { 9600, 57600, 115200, 1000000, 2000000, 3000000, 4000000, 4500000 };
+  for (int rate : baud_rates)
+  {
+    if (rate == baudrate)
+      return true;
+  }
+  return false;
+}
+
+int main(int argc, char *argv[])
+{
+  int baudrate = (argc > 1) ? atoi(argv[1]) : BAUDRATE;  // e.g. 1000000 once bus_config has switched the chain
+  if (!is_servo_baudrate(baudrate))
+  {
+    printf("Usage: %s [BAUDRATE]\n", argv[0]);
+    printf("  BAUDRATE: 9600, 57600, 115200, 1000000, 2000000, 3000000, 4000000 or 4500000 (default %d)\n", BAUDRATE);
+    return 1;
+  }
+
   // Initialize PortHandler instance
   // Set the port path
   // Get methods and members of PortHandlerLinux or PortHandlerWindows
@@ -1022,7 +1052,7 @@ int main()
   }
 
   // Set port baudrate
-  if (portHandler->setBaudRate(BAUDRATE))
+  if (portHandler->setBaudRate(baudrate))
   {
     printf("Succeeded to change the baudrate!\n");
   }
@@ -36,9 +36,8 @@ namespace dynamixel
 class WINDECLSPEC GroupBulkRead : public GroupHandler
 {
 protected:
-    std::map<uint8_t, uint16_t> address_list_;  // <id, start_address>
-    std::map<uint8_t, uint16_t> length_list_;   // <id, data_length>
-    std::map<uint8_t, uint8_t *> error_list_;   // <id, error>
+    uint16_t address_list_[256];                // <id, start_address>
+    uint8_t  error_list_[256];                  // <id, error>
 
     bool last_result_;
 
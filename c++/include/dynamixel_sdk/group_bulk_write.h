@@ -36,12 +36,9 @@ namespace dynamixel
 class WINDECLSPEC GroupBulkWrite : public GroupHandler
 {
 private:
-  std::map<uint8_t, uint16_t> address_list_;  // <id, start_address>
-  std::map<uint8_t, uint16_t> length_list_;   // <id, data_length>
+  uint16_t address_list_[256];                // <id, start_address>
 
-  uint16_t param_length_;
-
-  void makeParam();
+  void setSlotHeader(uint8_t id, uint16_t start_address, uint16_t data_length);
 
 public:
   ////////////////////////////////////////////////////////////////////////////////
@@ -75,6 +72,8 @@ public:
 
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that changes the data for write in id -> start_address -> data_length to the Bulk Write list
+  /// @description When start_address and data_length are unchanged, only the data is overwritten in place
+  /// @description in the parameters kept for the Bulk Write instruction packet.
   /// @param id Dynamixel ID
   /// @param start_address Address of the data for write
   /// @param data_length Length of the data for write
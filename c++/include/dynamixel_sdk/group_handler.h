@@ -23,7 +23,6 @@
 #define DYNAMIXEL_SDK_INCLUDE_DYNAMIXEL_SDK_GROUPHANDLER_H
 
 
-#include <map>
 #include <vector>
 #include "port_handler.h"
 #include "packet_handler.h"
@@ -40,15 +39,27 @@ public:
     PacketHandler *getPacketHandler() { return ph_; }
 
 protected:
+    static const uint16_t NOT_LISTED_ = 0xFFFF;  // data_offset_list_ value of an ID which is not in id_list_
+
     PortHandler *port_;
     PacketHandler *ph_;
 
     std::vector<uint8_t> id_list_;
-    std::map<uint8_t, uint8_t *> data_list_;     // <id, data>
+    std::vector<uint8_t> data_list_;             // data of every ID in id_list_, back to back in id_list_ order
+    uint16_t data_offset_list_[256];             // <id, offset of its data in data_list_>
+    uint16_t data_length_list_[256];             // <id, data_length>
 
     bool is_param_changed_;
 
     uint8_t *param_;
+
+    bool isListed(uint8_t id) { return data_offset_list_[id] != NOT_LISTED_; }
+    uint8_t *getDataPointer(uint8_t id) { return &data_list_[data_offset_list_[id]]; }
+
+    bool addDataSlot(uint8_t id, uint16_t data_length);
+    bool removeDataSlot(uint8_t id);
+    void resizeDataSlot(uint8_t id, uint16_t data_length);
+    void clearDataSlots();
 };
 
 }
@@ -39,8 +39,6 @@ private:
     uint16_t start_address_;
     uint16_t data_length_;
 
-    void makeParam();
-
 public:
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that Initializes instance for Sync Write
@@ -74,6 +72,8 @@ public:
 
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that changes the data for write in id -> start_address -> data_length to the Sync Write list
+  /// @description The data is overwritten in place in the parameters kept for the Sync Write instruction packet,
+  /// @description so calling this every control cycle does not rebuild the parameters or allocate memory.
   /// @param id Dynamixel ID
   /// @param data for replacement
   /// @return false
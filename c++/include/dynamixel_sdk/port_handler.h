@@ -45,6 +45,7 @@
 #define DEPRECATED
 #endif
 
+#include <stddef.h>
 #include <stdint.h>
 
 namespace dynamixel
@@ -169,6 +170,31 @@ class WINDECLSPEC PortHandler
   /// @description The function checks whether current time is passed by the time of packet timeout from the time set by PortHandlerLinux::setPacketTimeout().
   ////////////////////////////////////////////////////////////////////////////////
   virtual bool    isPacketTimeout() = 0;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the instruction packet buffer of the port
+  /// @description The function returns a 1024 byte buffer which the packet handler builds instruction packets in
+  /// @description while it holds the port, or NULL when the port handler keeps no packet buffers
+  /// @description and the packet handler allocates one per transaction.
+  /// @return NULL
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual uint8_t *getTxPacketBuffer()        { return NULL; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the byte stuffing buffer of the port
+  /// @description The function returns a 1024 byte buffer for the byte stuffed copy of an instruction packet
+  /// @description (used only when the packet contains FF FF FD), or NULL when the port handler keeps no packet buffers.
+  /// @return NULL
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual uint8_t *getTxStuffedPacketBuffer() { return NULL; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the status packet buffer of the port
+  /// @description The function returns a 1024 byte buffer which the packet handler receives status packets in
+  /// @description while it holds the port, or NULL when the port handler keeps no packet buffers.
+  /// @return NULL
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual uint8_t *getRxPacketBuffer()        { return NULL; }
 };
 
 }
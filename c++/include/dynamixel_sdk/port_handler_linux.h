@@ -38,16 +38,31 @@ class PortHandlerLinux : public PortHandler
   int     baudrate_;
   char    port_name_[100];
 
-  double  packet_start_time_;
-  double  packet_timeout_;
+  int64_t packet_start_time_ns_;
+  int64_t packet_timeout_ns_;
+  int64_t tx_start_time_ns_;
+  int64_t first_byte_time_ns_;
+  int64_t last_byte_time_ns_;
   double  tx_time_per_byte;
+  int     latency_timer_;
+
+  bool    blocking_read_;
+
+  static const int PACKET_BUFFER_LEN_ = 1024; // max. Protocol 2.0 packet
+
+  uint8_t tx_packet_[PACKET_BUFFER_LEN_];
+  uint8_t tx_stuffed_packet_[PACKET_BUFFER_LEN_];
+  uint8_t rx_packet_[PACKET_BUFFER_LEN_];
 
   bool    setupPort(const int cflag_baud);
   bool    setCustomBaudrate(int speed);
   int     getCFlagBaud(const int baudrate);
+  void    setLowLatency();
+  int     readLatencyTimer(const char *sysfs_path);
 
-  double  getCurrentTime();
-  double  getTimeSinceStart();
+  int64_t getTimeSinceStart();
+
+  void    waitReadable();
 
  public:
   ////////////////////////////////////////////////////////////////////////////////
@@ -64,7 +79,8 @@ class PortHandlerLinux : public PortHandler
 
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that opens the port
-  /// @description The function calls PortHandlerLinux::setBaudRate() to open the port.
+  /// @description The function calls PortHandlerLinux::setBaudRate() to open the port,
+  /// @description then lowers the USB-serial latency timer once for the adapter.
   /// @return communication results which come from PortHandlerLinux::setBaudRate()
   ////////////////////////////////////////////////////////////////////////////////
   bool    openPort();
@@ -132,6 +148,33 @@ class PortHandlerLinux : public PortHandler
   ////////////////////////////////////////////////////////////////////////////////
   int     readPort(uint8_t *packet, int length);
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the USB latency timer of the port
+  /// @description The function returns the latency timer read back when the port was opened.
+  /// @description PortHandlerLinux::openPort() asks USB-serial adapters for a 1 msec latency timer
+  /// @description (ASYNC_LOW_LATENCY, then sysfs) and pads packet timeouts by twice this value.
+  /// @return Latency timer in msec, 16 when the port does not report one
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getLatencyTimer();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that sets how PortHandlerLinux::readPort() waits for incoming bytes
+  /// @description The function selects the receive mode of the port.
+  /// @description In blocking mode (default), PortHandlerLinux::readPort() sleeps in poll() on the port
+  /// @description until a byte arrives or the packet timeout set by PortHandlerLinux::setPacketTimeout() expires,
+  /// @description so the packet handler no longer spins the CPU while waiting for a status packet.
+  /// @description In non-blocking mode, PortHandlerLinux::readPort() returns immediately as before.
+  /// @param blocking true for poll-based blocking receive, false for non-blocking receive
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setBlockingRead(bool blocking);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the receive mode of the port
+  /// @description The function returns whether PortHandlerLinux::readPort() waits for incoming bytes.
+  /// @return true when blocking receive is enabled
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    getBlockingRead();
+
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that writes bytes on the port buffer
   /// @description The function writes bytes on the port buffer,
@@ -163,6 +206,60 @@ class PortHandlerLinux : public PortHandler
   /// @description The function checks whether current time is passed by the time of packet timeout from the time set by PortHandlerLinux::setPacketTimeout().
   ////////////////////////////////////////////////////////////////////////////////
   bool    isPacketTimeout();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the clock used for packet timing
+  /// @description The function returns CLOCK_MONOTONIC_RAW in nanoseconds, which NTP neither steps nor slews.
+  /// @description The transaction timestamps below are on this clock.
+  /// @return Current time in nanoseconds
+  ////////////////////////////////////////////////////////////////////////////////
+  int64_t getCurrentTimeNs();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns when the last transaction started
+  /// @description The function returns the time PortHandlerLinux::writePort() was last called.
+  /// @return Time in nanoseconds (PortHandlerLinux::getCurrentTimeNs()), or 0 before the first write
+  ////////////////////////////////////////////////////////////////////////////////
+  int64_t getTxStartTime();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns when the first response byte of the last transaction arrived
+  /// @description The function returns the time of the first PortHandlerLinux::readPort() since the last write
+  /// @description that returned data. Its difference to PortHandlerLinux::getTxStartTime() is the request wire time,
+  /// @description the Return Delay Time of the servo and the USB latency.
+  /// @return Time in nanoseconds, or 0 when nothing has been received since the last write
+  ////////////////////////////////////////////////////////////////////////////////
+  int64_t getFirstByteTime();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns when the last response byte of the last transaction arrived
+  /// @description The function returns the time of the latest PortHandlerLinux::readPort() since the last write
+  /// @description that returned data. Time after it until the caller sees the result is host processing.
+  /// @return Time in nanoseconds, or 0 when nothing has been received since the last write
+  ////////////////////////////////////////////////////////////////////////////////
+  int64_t getLastByteTime();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the instruction packet buffer of the port
+  /// @description The function returns the buffer the packet handler builds instruction packets in,
+  /// @description so that a transaction makes no heap allocation. It belongs to whichever transaction holds the port.
+  /// @return Buffer of 1024 bytes
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t *getTxPacketBuffer();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the byte stuffing buffer of the port
+  /// @description The function returns the buffer for the byte stuffed copy of an instruction packet.
+  /// @return Buffer of 1024 bytes
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t *getTxStuffedPacketBuffer();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the status packet buffer of the port
+  /// @description The function returns the buffer the packet handler receives status packets in.
+  /// @return Buffer of 1024 bytes
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t *getRxPacketBuffer();
 };
 
 }
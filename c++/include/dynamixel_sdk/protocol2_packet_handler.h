@@ -38,8 +38,8 @@ class WINDECLSPEC Protocol2PacketHandler : public PacketHandler
 
   Protocol2PacketHandler();
 
-  uint16_t    updateCRC(uint16_t crc_accum, uint8_t *data_blk_ptr, uint16_t data_blk_size);
-  void        addStuffing(uint8_t *packet);
+  uint16_t    countStuffing(uint8_t *packet);
+  void        addStuffing(uint8_t *packet, uint8_t *stuffed_packet, uint16_t stuffing_length);
   void        removeStuffing(uint8_t *packet);
 
  public:
@@ -51,6 +51,17 @@ class WINDECLSPEC Protocol2PacketHandler : public PacketHandler
 
   virtual ~Protocol2PacketHandler() { }
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that calculates the CRC-16 of the Protocol 2.0 packet
+  /// @description The function continues the CRC-16 calculation of crc_accum over data_blk_size bytes of data_blk_ptr.
+  /// @description The calculation is table-driven and processes eight bytes per step (slicing-by-8).
+  /// @param crc_accum CRC-16 of the preceding bytes (0 at the start of a packet)
+  /// @param data_blk_ptr Bytes to be added to the CRC-16
+  /// @param data_blk_size Number of the bytes
+  /// @return CRC-16 including the data_blk_ptr bytes
+  ////////////////////////////////////////////////////////////////////////////////
+  uint16_t    updateCRC(uint16_t crc_accum, uint8_t *data_blk_ptr, uint16_t data_blk_size);
+
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that returns Protocol version used in Protocol2PacketHandler (2.0)
   /// @return 2.0
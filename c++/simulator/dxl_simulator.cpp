@@ -0,0 +1,813 @@
+//
+// *********     Virtual Dynamixel Chain      *********
+//
+// See dxl_simulator.h.
+//
+
+#include "dxl_simulator.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "dynamixel_sdk.h"                                  // Uses Dynamixel SDK library
+#include "protocol2_packet_handler.h"
+
+// Control table (X series)
+#define ADDR_MODEL_NUMBER               0
+#define ADDR_FIRMWARE_VERSION           6
+#define ADDR_ID                         7
+#define ADDR_BAUD_RATE                  8
+#define ADDR_RETURN_DELAY_TIME          9
+#define ADDR_DRIVE_MODE                 10
+#define ADDR_OPERATING_MODE             11
+#define ADDR_VELOCITY_LIMIT             44
+#define ADDR_TORQUE_ENABLE              64
+#define ADDR_STATUS_RETURN_LEVEL        68
+#define ADDR_REGISTERED_INSTRUCTION     69
+#define ADDR_HARDWARE_ERROR_STATUS      70
+#define ADDR_PROFILE_VELOCITY           112
+#define ADDR_GOAL_POSITION              116
+#define ADDR_REALTIME_TICK              120
+#define ADDR_MOVING                     122
+#define ADDR_PRESENT_CURRENT            126
+#define ADDR_PRESENT_VELOCITY           128
+#define ADDR_PRESENT_POSITION           132
+#define ADDR_PRESENT_INPUT_VOLTAGE      144
+#define ADDR_PRESENT_TEMPERATURE        146
+#define ADDR_INDIRECT_ADDRESS_1         168
+#define ADDR_INDIRECT_DATA_1            224
+#define ADDR_INDIRECT_ADDRESS_29        578
+#define ADDR_INDIRECT_DATA_29           634
+#define NUM_INDIRECT_BLOCK              28
+
+#define SIM_MODEL_NUMBER                1060                // XL430-W250
+#define SIM_FIRMWARE_VERSION            46
+#define SIM_MAX_SPEED_TICKS             3891.0              // 57 rev/min without load
+#define SIM_VELOCITY_UNIT_TICKS         (0.229 * 4096.0 / 60.0)  // ticks/s per Present Velocity unit
+
+#define DRIVE_MODE_TIME_BASED_PROFILE   0x04
+#define HARDWARE_ALERT                  0x80
+
+// Protocol 2.0 packet layout and error numbers
+#define PKT_ID                          4
+#define PKT_LENGTH_L                    5
+#define PKT_LENGTH_H                    6
+#define PKT_INSTRUCTION                 7
+#define PKT_PARAMETER0                  8
+#define ERRNUM_RESULT_FAIL              1
+#define ERRNUM_INSTRUCTION              2
+#define ERRNUM_CRC                      3
+#define ERRNUM_DATA_RANGE               4
+#define ERRNUM_DATA_LENGTH              5
+#define ERRNUM_ACCESS                   7
+
+static const int BAUDRATES[] = { 9600, 57600, 115200, 1000000, 2000000, 3000000, 4000000, 4500000 };
+
+static uint16_t updateCRC(uint16_t crc, const uint8_t *data, uint16_t length)
+{
+  return dynamixel::Protocol2PacketHandler::getInstance()->updateCRC(crc, (uint8_t *)data, length);
+}
+
+// ---------------------------------------------------------------------------------------------
+// VirtualServo
+// ---------------------------------------------------------------------------------------------
+
+VirtualServo::VirtualServo()
+  : no_response_(false), position_(2048.0), speed_(0.0), last_update_(0.0)
+{
+  reset(1, 1, 250, false);
+}
+
+void VirtualServo::reset(uint8_t id, uint8_t baud_index, uint8_t return_delay, bool keep_id_and_baud)
+{
+  if (keep_id_and_baud)
+  {
+    id = table_[ADDR_ID];
+    baud_index = table_[ADDR_BAUD_RATE];
+  }
+  memset(table_, 0, sizeof(table_));
+
+  set2(ADDR_MODEL_NUMBER, SIM_MODEL_NUMBER);
+  table_[ADDR_FIRMWARE_VERSION] = SIM_FIRMWARE_VERSION;
+  table_[ADDR_ID] = id;
+  table_[ADDR_BAUD_RATE] = baud_index;
+  table_[ADDR_RETURN_DELAY_TIME] = return_delay;
+  table_[ADDR_OPERATING_MODE] = 3;                          // Position control
+  table_[12] = 255;                                         // Secondary ID
+  table_[13] = 2;                                           // Protocol type
+  set4(24, 10);                                             // Moving threshold
+  table_[31] = 72;                                          // Temperature limit
+  set2(32, 140);                                            // Max voltage limit
+  set2(34, 60);                                             // Min voltage limit
+  set2(36, 885);                                            // PWM limit
+  set4(ADDR_VELOCITY_LIMIT, 265);
+  set4(48, 4095);                                           // Max position limit
+  table_[63] = 52;                                          // Shutdown
+  table_[ADDR_STATUS_RETURN_LEVEL] = 2;
+  set2(76, 1920);                                           // Velocity I gain
+  set2(78, 100);                                            // Velocity P gain
+  set2(84, 640);                                            // Position P gain
+  set2(100, 885);                                           // Goal PWM
+  set4(ADDR_GOAL_POSITION, (uint32_t)lround(position_));
+  set4(ADDR_PRESENT_POSITION, (uint32_t)lround(position_));
+  set2(ADDR_PRESENT_INPUT_VOLTAGE, 120);
+  table_[ADDR_PRESENT_TEMPERATURE] = 30;
+  for (int i = 0; i < NUM_INDIRECT_BLOCK; i++)
+  {
+    set2(ADDR_INDIRECT_ADDRESS_1 + i * 2, ADDR_INDIRECT_DATA_1 + i);
+    set2(ADDR_INDIRECT_ADDRESS_29 + i * 2, ADDR_INDIRECT_DATA_29 + i);
+  }
+  registered_.clear();
+  speed_ = 0.0;
+}
+
+uint32_t VirtualServo::get4(uint16_t address)
+{
+  return DXL_MAKEDWORD(DXL_MAKEWORD(table_[address], table_[address + 1]), DXL_MAKEWORD(table_[address + 2], table_[address + 3]));
+}
+
+void VirtualServo::set2(uint16_t address, uint16_t value)
+{
+  table_[address] = DXL_LOBYTE(value);
+  table_[address + 1] = DXL_HIBYTE(value);
+}
+
+void VirtualServo::set4(uint16_t address, uint32_t value)
+{
+  set2(address, DXL_LOWORD(value));
+  set2(address + 2, DXL_HIWORD(value));
+}
+
+uint16_t VirtualServo::mapAddress(uint16_t address)
+{
+  if (address >= ADDR_INDIRECT_DATA_1 && address < ADDR_INDIRECT_DATA_1 + NUM_INDIRECT_BLOCK)
+  {
+    uint16_t entry = ADDR_INDIRECT_ADDRESS_1 + (address - ADDR_INDIRECT_DATA_1) * 2;
+    return DXL_MAKEWORD(table_[entry], table_[entry + 1]);
+  }
+  if (address >= ADDR_INDIRECT_DATA_29 && address < ADDR_INDIRECT_DATA_29 + NUM_INDIRECT_BLOCK)
+  {
+    uint16_t entry = ADDR_INDIRECT_ADDRESS_29 + (address - ADDR_INDIRECT_DATA_29) * 2;
+    return DXL_MAKEWORD(table_[entry], table_[entry + 1]);
+  }
+  return address;
+}
+
+bool VirtualServo::isWritable(uint16_t address)
+{
+  bool torque_on = table_[ADDR_TORQUE_ENABLE] != 0;
+  if (address < ADDR_ID || address == ADDR_REGISTERED_INSTRUCTION || address == ADDR_HARDWARE_ERROR_STATUS)
+    return false;
+  if (address >= ADDR_REALTIME_TICK && address <= ADDR_PRESENT_TEMPERATURE)
+    return false;                                           // Present values
+  if (address < ADDR_TORQUE_ENABLE ||
+      (address >= ADDR_INDIRECT_ADDRESS_1 && address < ADDR_INDIRECT_DATA_1) ||
+      (address >= ADDR_INDIRECT_ADDRESS_29 && address < ADDR_INDIRECT_DATA_29))
+    return !torque_on;                                      // EEPROM area
+  return true;
+}
+
+void VirtualServo::update(double now)
+{
+  double dt = now - last_update_;
+  last_update_ = now;
+  if (dt < 0.0 || dt > 1.0)
+    dt = 0.0;
+
+  double goal = (double)(int32_t)get4(ADDR_GOAL_POSITION);
+  double velocity = 0.0;
+  if (table_[ADDR_TORQUE_ENABLE] && speed_ > 0.0 && position_ != goal)
+  {
+    double step = speed_ * dt;
+    if (fabs(goal - position_) <= step)
+    {
+      velocity = (goal - position_) / (dt > 0.0 ? dt : 1.0);
+      position_ = goal;
+    }
+    else
+    {
+      velocity = (goal > position_) ? speed_ : -speed_;
+      position_ += (goal > position_) ? step : -step;
+    }
+  }
+
+  set4(ADDR_PRESENT_POSITION, (uint32_t)(int32_t)lround(position_));
+  set4(ADDR_PRESENT_VELOCITY, (uint32_t)(int32_t)lround(velocity / SIM_VELOCITY_UNIT_TICKS));
+  set2(ADDR_PRESENT_CURRENT, (uint16_t)(int16_t)(table_[ADDR_TORQUE_ENABLE] ? 5 + lround(fabs(velocity) / 40.0) : 0));
+  set2(ADDR_REALTIME_TICK, (uint16_t)((uint64_t)(now * 1000.0) % 32768));
+  table_[ADDR_MOVING] = (table_[ADDR_TORQUE_ENABLE] && position_ != goal) ? 1 : 0;
+}
+
+void VirtualServo::startMove(double now)
+{
+  update(now);
+  double distance = fabs((double)(int32_t)get4(ADDR_GOAL_POSITION) - position_);
+  uint32_t profile_velocity = get4(ADDR_PROFILE_VELOCITY);
+  double max_speed = get4(ADDR_VELOCITY_LIMIT) * SIM_VELOCITY_UNIT_TICKS;
+  if (max_speed <= 0.0 || max_speed > SIM_MAX_SPEED_TICKS)
+    max_speed = SIM_MAX_SPEED_TICKS;
+
+  if (table_[ADDR_DRIVE_MODE] & DRIVE_MODE_TIME_BASED_PROFILE)
+    speed_ = (profile_velocity > 0) ? distance / (profile_velocity / 1000.0) : max_speed;   // Profile Velocity = move time (ms)
+  else
+    speed_ = (profile_velocity > 0) ? profile_velocity * SIM_VELOCITY_UNIT_TICKS : max_speed;
+  if (speed_ > max_speed)
+    speed_ = max_speed;
+}
+
+uint8_t VirtualServo::read(uint16_t address, uint16_t length, uint8_t *data, double now)
+{
+  if (address + length > SIM_CONTROL_TABLE_SIZE)
+    return ERRNUM_DATA_LENGTH;
+
+  update(now);
+  for (uint16_t i = 0; i < length; i++)
+  {
+    uint16_t mapped = mapAddress(address + i);
+    data[i] = (mapped < SIM_CONTROL_TABLE_SIZE) ? table_[mapped] : 0;
+  }
+  return 0;
+}
+
+uint8_t VirtualServo::write(uint16_t address, uint16_t length, const uint8_t *data, double now)
+{
+  if (address + length > SIM_CONTROL_TABLE_SIZE)
+    return ERRNUM_DATA_LENGTH;
+  for (uint16_t i = 0; i < length; i++)
+  {
+    uint16_t mapped = mapAddress(address + i);
+    if (mapped >= SIM_CONTROL_TABLE_SIZE || !isWritable(mapped))
+      return ERRNUM_ACCESS;
+  }
+
+  update(now);
+  bool goal_changed = false;
+  for (uint16_t i = 0; i < length; i++)
+  {
+    uint16_t mapped = mapAddress(address + i);
+    if (mapped == ADDR_TORQUE_ENABLE && data[i] && !table_[ADDR_TORQUE_ENABLE])
+      set4(ADDR_GOAL_POSITION, (uint32_t)(int32_t)lround(position_));   // Torque on holds the present position
+    table_[mapped] = data[i];
+    if (mapped >= ADDR_GOAL_POSITION && mapped < ADDR_GOAL_POSITION + 4)
+      goal_changed = true;
+  }
+  if (goal_changed)
+    startMove(now);
+  return 0;
+}
+
+// ---------------------------------------------------------------------------------------------
+// DxlSimulator
+// ---------------------------------------------------------------------------------------------
+
+DxlSimulator::DxlSimulator(const SimOptions &options)
+  : options_(options), master_fd_(-1), slave_fd_(-1), running_(false), thread_started_(false),
+    random_state_(options.seed ? options.seed : 1), tx_ready_time_(0.0)
+{
+  port_name_[0] = '\0';
+  link_path_[0] = '\0';
+  memset(&stats_, 0, sizeof(stats_));
+  for (int id = 0; id < SIM_MAX_SERVOS; id++)
+  {
+    present_[id] = (id >= options_.first_id && id <= options_.last_id);
+    servos_[id].reset(id, options_.baud_index, options_.return_delay, false);
+  }
+}
+
+DxlSimulator::~DxlSimulator()
+{
+  stop();
+  if (link_path_[0] != '\0')
+    unlink(link_path_);
+  if (slave_fd_ >= 0)
+    close(slave_fd_);
+  if (master_fd_ >= 0)
+    close(master_fd_);
+}
+
+bool DxlSimulator::open(const char *link_path)
+{
+  master_fd_ = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master_fd_ < 0 || grantpt(master_fd_) != 0 || unlockpt(master_fd_) != 0)
+  {
+    perror("[DxlSimulator] posix_openpt");
+    return false;
+  }
+  if (ptsname_r(master_fd_, port_name_, sizeof(port_name_)) != 0)
+  {
+    perror("[DxlSimulator] ptsname");
+    return false;
+  }
+
+  // Raw line discipline until the client configures the port itself
+  slave_fd_ = ::open(port_name_, O_RDWR | O_NOCTTY);
+  if (slave_fd_ < 0)
+  {
+    perror("[DxlSimulator] open slave");
+    return false;
+  }
+  struct termios tio;
+  tcgetattr(slave_fd_, &tio);
+  cfmakeraw(&tio);
+  cfsetspeed(&tio, B57600);
+  tcsetattr(slave_fd_, TCSANOW, &tio);
+
+  if (link_path != NULL)
+  {
+    unlink(link_path);
+    if (symlink(port_name_, link_path) != 0)
+    {
+      perror("[DxlSimulator] symlink");
+      return false;
+    }
+    snprintf(link_path_, sizeof(link_path_), "%s", link_path);
+  }
+  return true;
+}
+
+VirtualServo *DxlSimulator::getServo(uint8_t id)
+{
+  return (id < SIM_MAX_SERVOS && present_[id]) ? &servos_[id] : NULL;
+}
+
+void *DxlSimulator::threadMain(void *arg)
+{
+  ((DxlSimulator *)arg)->run();
+  return NULL;
+}
+
+bool DxlSimulator::start()
+{
+  running_ = true;
+  thread_started_ = (pthread_create(&thread_, NULL, threadMain, this) == 0);
+  return thread_started_;
+}
+
+void DxlSimulator::stop()
+{
+  running_ = false;
+  if (thread_started_)
+  {
+    pthread_join(thread_, NULL);
+    thread_started_ = false;
+  }
+}
+
+double DxlSimulator::now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+double DxlSimulator::random01()
+{
+  random_state_ = random_state_ * 1103515245u + 12345u;
+  return (double)((random_state_ >> 8) & 0xFFFFFF) / (double)0x1000000;
+}
+
+void DxlSimulator::sleepUntil(double time)
+{
+  struct timespec ts;
+  ts.tv_sec = (time_t)time;
+  ts.tv_nsec = (long)((time - (double)ts.tv_sec) * 1e9);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    ;
+}
+
+int DxlSimulator::getHostBaudrate()
+{
+  struct termios tio;
+  if (tcgetattr(slave_fd_, &tio) != 0)
+    return 0;
+  switch (cfgetospeed(&tio))
+  {
+    case B9600:     return 9600;
+    case B57600:    return 57600;
+    case B115200:   return 115200;
+    case B1000000:  return 1000000;
+    case B2000000:  return 2000000;
+    case B3000000:  return 3000000;
+    case B4000000:  return 4000000;
+    default:        return 0;
+  }
+}
+
+bool DxlSimulator::servoAtBaudrate(int baudrate)
+{
+  for (int id = 0; id < SIM_MAX_SERVOS; id++)
+  {
+    if (present_[id] && BAUDRATES[servos_[id].getBaudIndex() & 7] == baudrate)
+      return true;
+  }
+  return false;
+}
+
+bool DxlSimulator::hearsHost(uint8_t id)
+{
+  if (id >= SIM_MAX_SERVOS || !present_[id])
+    return false;
+  return !options_.check_baud || BAUDRATES[servos_[id].getBaudIndex() & 7] == getHostBaudrate();
+}
+
+double DxlSimulator::getByteTime()
+{
+  int baudrate = getHostBaudrate();
+  if (baudrate == 0)
+    baudrate = BAUDRATES[options_.baud_index & 7];
+  return options_.model_wire_time ? 10.0 / baudrate : 0.0;  // Start + 8 data + stop bits
+}
+
+bool DxlSimulator::respondsTo(uint8_t id, uint8_t instruction)
+{
+  if (!hearsHost(id) || servos_[id].no_response_)
+    return false;                                           // A servo at another baud sees noise
+  uint8_t level = servos_[id].getStatusReturnLevel();
+  if (instruction == INST_PING)
+    return true;
+  if (instruction == INST_READ || instruction == INST_SYNC_READ || instruction == INST_BULK_READ ||
+      instruction == INST_FAST_SYNC_READ || instruction == INST_FAST_BULK_READ)
+    return level >= 1;
+  return level >= 2;
+}
+
+void DxlSimulator::run()
+{
+  running_ = true;
+  uint8_t buffer[1024];
+  while (running_)
+  {
+    struct pollfd pfd = { master_fd_, POLLIN, 0 };
+    if (poll(&pfd, 1, 100) <= 0)
+      continue;
+
+    int length = ::read(master_fd_, buffer, sizeof(buffer));
+    if (length <= 0)
+      continue;
+    rx_buffer_.insert(rx_buffer_.end(), buffer, buffer + length);
+    processPackets();
+  }
+}
+
+void DxlSimulator::processPackets()
+{
+  while (true)
+  {
+    // Find the header FF FF FD 00
+    size_t start = 0;
+    while (start + 4 <= rx_buffer_.size() &&
+           !(rx_buffer_[start] == 0xFF && rx_buffer_[start + 1] == 0xFF && rx_buffer_[start + 2] == 0xFD && rx_buffer_[start + 3] == 0x00))
+      start++;
+    if (start > 0)
+      rx_buffer_.erase(rx_buffer_.begin(), rx_buffer_.begin() + start);
+    if (rx_buffer_.size() < PKT_INSTRUCTION + 1)
+      return;
+
+    uint16_t length = DXL_MAKEWORD(rx_buffer_[PKT_LENGTH_L], rx_buffer_[PKT_LENGTH_H]) + PKT_LENGTH_H + 1;
+    if (length < 10 || length > 1024)
+    {
+      stats_.ignored_packets++;
+      rx_buffer_.erase(rx_buffer_.begin());
+      continue;
+    }
+    if (rx_buffer_.size() < length)
+      return;
+
+    std::vector<uint8_t> packet(rx_buffer_.begin(), rx_buffer_.begin() + length);
+    rx_buffer_.erase(rx_buffer_.begin(), rx_buffer_.begin() + length);
+    if (packet[PKT_INSTRUCTION] == INST_STATUS)
+      continue;                                             // Our own status packets echoed back
+
+    stats_.instruction_packets++;
+    uint16_t crc = DXL_MAKEWORD(packet[length - 2], packet[length - 1]);
+    if (updateCRC(0, &packet[0], length - 2) != crc)
+    {
+      stats_.crc_errors++;
+      uint8_t id = packet[PKT_ID];
+      if (id != BROADCAST_ID && respondsTo(id, INST_PING))
+      {
+        tx_queue_.clear();
+        tx_ready_time_ = now() + length * getByteTime();    // The request is on the wire first
+        queueStatus(id, ERRNUM_CRC, NULL, 0);
+        flushStatus();
+      }
+      continue;
+    }
+    handleInstruction(&packet[0], length);
+  }
+}
+
+void DxlSimulator::handleInstruction(const uint8_t *raw, uint16_t raw_length)
+{
+  if (options_.check_baud && !servoAtBaudrate(getHostBaudrate()))
+  {
+    stats_.ignored_packets++;                               // Framing errors on every servo
+    return;
+  }
+
+  double request_time = now();
+  double t = request_time;
+  uint8_t id = raw[PKT_ID];
+  uint8_t instruction = raw[PKT_INSTRUCTION];
+
+  // Parameters without byte stuffing (FF FF FD FD -> FF FF FD)
+  std::vector<uint8_t> params;
+  for (uint16_t i = PKT_PARAMETER0; i < raw_length - 2; i++)
+  {
+    size_t n = params.size();
+    if (raw[i] == 0xFD && n >= 3 && params[n - 1] == 0xFD && params[n - 2] == 0xFF && params[n - 3] == 0xFF)
+      continue;
+    params.push_back(raw[i]);
+  }
+  const uint8_t *p = params.empty() ? NULL : &params[0];
+  uint16_t n = params.size();
+  uint8_t data[SIM_CONTROL_TABLE_SIZE];
+  tx_queue_.clear();
+  tx_ready_time_ = request_time + raw_length * getByteTime();
+
+  switch (instruction)
+  {
+    case INST_PING:
+      for (int target = 0; target < SIM_MAX_SERVOS; target++)
+      {
+        if ((id == BROADCAST_ID || id == target) && respondsTo(target, INST_PING))
+        {
+          uint8_t info[3];
+          servos_[target].read(ADDR_MODEL_NUMBER, 2, info, t);
+          servos_[target].read(ADDR_FIRMWARE_VERSION, 1, &info[2], t);
+          queueStatus(target, 0, info, 3);
+        }
+      }
+      break;
+
+    case INST_READ:
+      if (n == 4 && respondsTo(id, instruction))
+      {
+        uint16_t address = DXL_MAKEWORD(p[0], p[1]), length = DXL_MAKEWORD(p[2], p[3]);
+        uint8_t error = servos_[id].read(address, length, data, t);
+        queueStatus(id, error, data, error ? 0 : length);
+      }
+      break;
+
+    case INST_WRITE:
+    case INST_REG_WRITE:
+      for (int target = 0; n >= 2 && target < SIM_MAX_SERVOS; target++)
+      {
+        if (!hearsHost(target) || (id != BROADCAST_ID && id != target))
+          continue;
+        uint8_t error = 0;
+        bool responds = (id != BROADCAST_ID && respondsTo(target, instruction));   // At the baud before this write
+        if (instruction == INST_WRITE)
+        {
+          error = servos_[target].write(DXL_MAKEWORD(p[0], p[1]), n - 2, p + 2, t);
+        }
+        else
+        {
+          servos_[target].registered_.assign(p, p + n);
+        }
+        if (responds)
+          queueStatus(target, error, NULL, 0);
+      }
+      break;
+
+    case INST_ACTION:
+      for (int target = 0; target < SIM_MAX_SERVOS; target++)
+      {
+        if (!hearsHost(target) || (id != BROADCAST_ID && id != target) || servos_[target].registered_.size() < 2)
+          continue;
+        std::vector<uint8_t> &reg = servos_[target].registered_;
+        bool responds = (id != BROADCAST_ID && respondsTo(target, instruction));
+        servos_[target].write(DXL_MAKEWORD(reg[0], reg[1]), reg.size() - 2, &reg[2], t);
+        reg.clear();
+        if (responds)
+          queueStatus(target, 0, NULL, 0);
+      }
+      break;
+
+    case INST_FACTORY_RESET:
+    case INST_REBOOT:
+    case INST_CLEAR:
+      if (id != BROADCAST_ID && respondsTo(id, instruction))
+        queueStatus(id, 0, NULL, 0);
+      for (int target = 0; target < SIM_MAX_SERVOS; target++)
+      {
+        if (!hearsHost(target) || (id != BROADCAST_ID && id != target))
+          continue;
+        if (instruction == INST_FACTORY_RESET)
+          servos_[target].reset(target, options_.baud_index, options_.return_delay, n >= 1 && p[0] != 0xFF);
+        else if (instruction == INST_REBOOT)
+        {
+          uint8_t eeprom[ADDR_TORQUE_ENABLE];
+          servos_[target].read(0, sizeof(eeprom), eeprom, t);
+          servos_[target].reset(target, options_.baud_index, options_.return_delay, true);
+          servos_[target].write(ADDR_ID, sizeof(eeprom) - ADDR_ID, eeprom + ADDR_ID, t);
+        }
+      }
+      break;
+
+    case INST_SYNC_READ:
+    case INST_FAST_SYNC_READ:
+    {
+      if (n < 4)
+        break;
+      uint16_t address = DXL_MAKEWORD(p[0], p[1]), length = DXL_MAKEWORD(p[2], p[3]);
+      std::vector<uint8_t> ids(p + 4, p + n);
+      if (instruction == INST_FAST_SYNC_READ)
+      {
+        queueFastStatus(ids, std::vector<uint16_t>(ids.size(), address), std::vector<uint16_t>(ids.size(), length));
+        break;
+      }
+      for (size_t i = 0; i < ids.size(); i++)
+      {
+        if (!respondsTo(ids[i], instruction))
+          continue;
+        uint8_t error = servos_[ids[i]].read(address, length, data, t);
+        queueStatus(ids[i], error, data, error ? 0 : length);
+      }
+      break;
+    }
+
+    case INST_BULK_READ:
+    case INST_FAST_BULK_READ:
+    {
+      std::vector<uint8_t> ids;
+      std::vector<uint16_t> addresses, lengths;
+      for (uint16_t i = 0; i + 5 <= n; i += 5)
+      {
+        ids.push_back(p[i]);
+        addresses.push_back(DXL_MAKEWORD(p[i + 1], p[i + 2]));
+        lengths.push_back(DXL_MAKEWORD(p[i + 3], p[i + 4]));
+      }
+      if (instruction == INST_FAST_BULK_READ)
+      {
+        queueFastStatus(ids, addresses, lengths);
+        break;
+      }
+      for (size_t i = 0; i < ids.size(); i++)
+      {
+        if (!respondsTo(ids[i], instruction))
+          continue;
+        uint8_t error = servos_[ids[i]].read(addresses[i], lengths[i], data, t);
+        queueStatus(ids[i], error, data, error ? 0 : lengths[i]);
+      }
+      break;
+    }
+
+    case INST_SYNC_WRITE:
+    {
+      if (n < 4)
+        break;
+      uint16_t address = DXL_MAKEWORD(p[0], p[1]), length = DXL_MAKEWORD(p[2], p[3]);
+      for (uint16_t i = 4; i + 1 + length <= n; i += 1 + length)
+      {
+        if (hearsHost(p[i]))
+          servos_[p[i]].write(address, length, p + i + 1, t);
+      }
+      stats_.sync_write_packets++;
+      break;
+    }
+
+    case INST_BULK_WRITE:
+      for (uint16_t i = 0; i + 5 <= n; )
+      {
+        uint8_t target = p[i];
+        uint16_t address = DXL_MAKEWORD(p[i + 1], p[i + 2]), length = DXL_MAKEWORD(p[i + 3], p[i + 4]);
+        if (i + 5 + length > n)
+          break;
+        if (hearsHost(target))
+          servos_[target].write(address, length, p + i + 5, t);
+        i += 5 + length;
+      }
+      break;
+
+    default:
+      if (id != BROADCAST_ID && respondsTo(id, INST_PING))
+        queueStatus(id, ERRNUM_INSTRUCTION, NULL, 0);
+      break;
+  }
+
+  flushStatus();
+}
+
+void DxlSimulator::queuePacket(std::vector<uint8_t> &packet, bool stuffing)
+{
+  if (stuffing)
+  {
+    // FF FF FD in the instruction/parameter field is sent as FF FF FD FD
+    std::vector<uint8_t> stuffed(packet.begin(), packet.begin() + PKT_INSTRUCTION);
+    for (size_t i = PKT_INSTRUCTION; i < packet.size(); i++)
+    {
+      stuffed.push_back(packet[i]);
+      size_t n = stuffed.size();
+      if (packet[i] == 0xFD && n - PKT_INSTRUCTION >= 3 && stuffed[n - 2] == 0xFF && stuffed[n - 3] == 0xFF)
+        stuffed.push_back(0xFD);
+    }
+    packet.swap(stuffed);
+    uint16_t length = packet.size() + 2 - (PKT_LENGTH_H + 1);
+    packet[PKT_LENGTH_L] = DXL_LOBYTE(length);
+    packet[PKT_LENGTH_H] = DXL_HIBYTE(length);
+    uint16_t crc = updateCRC(0, &packet[0], packet.size());
+    packet.push_back(DXL_LOBYTE(crc));
+    packet.push_back(DXL_HIBYTE(crc));
+  }
+
+  stats_.status_packets++;
+  if (options_.drop_rate > 0.0 && random01() < options_.drop_rate)
+  {
+    stats_.dropped_packets++;
+    return;
+  }
+  if (options_.corrupt_rate > 0.0 && random01() < options_.corrupt_rate)
+  {
+    stats_.corrupted_packets++;
+    packet[packet.size() - 1] ^= 0x5A;
+  }
+
+  // Each servo waits its Return Delay Time after the bus goes idle, then transmits
+  double jitter = (options_.jitter_us > 0) ? random01() * options_.jitter_us * 1e-6 : 0.0;
+  tx_ready_time_ += jitter + packet.size() * getByteTime();
+  PendingStatus status;
+  status.ready_time = tx_ready_time_;
+  status.bytes.swap(packet);
+  tx_queue_.push_back(status);
+}
+
+void DxlSimulator::queueStatus(uint8_t id, uint8_t error, const uint8_t *params, uint16_t param_length)
+{
+  if (servos_[id].getHardwareError() != 0)
+    error |= HARDWARE_ALERT;
+  tx_ready_time_ += servos_[id].getReturnDelay() * 2e-6;
+
+  // Header, ID, length (filled in by queuePacket), instruction, error, parameters
+  std::vector<uint8_t> packet = { 0xFF, 0xFF, 0xFD, 0x00, id, 0, 0, INST_STATUS, error };
+  if (param_length > 0)
+    packet.insert(packet.end(), params, params + param_length);
+  queuePacket(packet, true);
+}
+
+void DxlSimulator::queueFastStatus(const std::vector<uint8_t> &ids, const std::vector<uint16_t> &addresses,
+                                   const std::vector<uint16_t> &lengths)
+{
+  // Every servo appends its block to one packet; a missing servo breaks the chain and nothing arrives
+  size_t total = 0;
+  for (size_t i = 0; i < ids.size(); i++)
+  {
+    if (!respondsTo(ids[i], INST_FAST_SYNC_READ))
+      return;
+    total += lengths[i] + 4;
+  }
+  if (ids.empty())
+    return;
+
+  uint16_t length = total + 1;
+  std::vector<uint8_t> packet = { 0xFF, 0xFF, 0xFD, 0x00, BROADCAST_ID, DXL_LOBYTE(length), DXL_HIBYTE(length), INST_STATUS };
+  uint8_t data[SIM_CONTROL_TABLE_SIZE];
+  for (size_t i = 0; i < ids.size(); i++)
+  {
+    VirtualServo &servo = servos_[ids[i]];
+    uint8_t error = servo.read(addresses[i], lengths[i], data, now());
+    if (servo.getHardwareError() != 0)
+      error |= HARDWARE_ALERT;
+    if (error & 0x7F)
+      memset(data, 0, lengths[i]);
+    packet.push_back(error);
+    packet.push_back(ids[i]);
+    packet.insert(packet.end(), data, data + lengths[i]);
+    uint16_t crc = updateCRC(0, &packet[0], packet.size());   // CRC of the packet so far; the last one ends the packet
+    packet.push_back(DXL_LOBYTE(crc));
+    packet.push_back(DXL_HIBYTE(crc));
+    tx_ready_time_ += (i == 0) ? servo.getReturnDelay() * 2e-6 : 0.0;
+  }
+  queuePacket(packet, false);
+}
+
+void DxlSimulator::flushStatus()
+{
+  // Each servo answers on its own, so the host sees the packets arrive one by one
+  for (size_t i = 0; i < tx_queue_.size(); i++)
+  {
+    const std::vector<uint8_t> &bytes = tx_queue_[i].bytes;
+    sleepUntil(tx_queue_[i].ready_time + options_.usb_latency_us * 1e-6);
+    size_t written = 0;
+    while (written < bytes.size())
+    {
+      int result = ::write(master_fd_, &bytes[written], bytes.size() - written);
+      if (result <= 0)
+      {
+        if (errno == EAGAIN || errno == EINTR)
+          continue;
+        break;
+      }
+      written += result;
+    }
+  }
+  tx_queue_.clear();
+}
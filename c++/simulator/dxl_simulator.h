@@ -0,0 +1,151 @@
+//
+// *********     Virtual Dynamixel Chain      *********
+//
+//
+// Emulates a chain of Protocol 2.0 X-series servos behind a pseudo-terminal, so the SDK
+// (PortHandlerLinux, Protocol2PacketHandler, the group handlers) and programs built on it can
+// run without /dev/ttyUSB0. Open the slave side of the pty like any serial port.
+//
+// Supported: ping, read, write, reg write/action, reboot, factory reset, clear, sync read/write,
+// bulk read/write, fast sync/bulk read, indirect addresses, status return level and return delay.
+// Wire time is modelled from the Baud Rate register of the servos, and faults can be injected.
+//
+
+#ifndef DYNAMIXEL_SDK_SIMULATOR_DXL_SIMULATOR_H_
+#define DYNAMIXEL_SDK_SIMULATOR_DXL_SIMULATOR_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include <vector>
+
+#define SIM_CONTROL_TABLE_SIZE          662     // Up to Indirect Data 56
+#define SIM_MAX_SERVOS                  253     // IDs 0 - 252
+
+struct SimOptions
+{
+  int      first_id;            // Servos first_id..last_id are on the chain
+  int      last_id;
+  uint8_t  baud_index;          // Baud Rate register of every servo: 0 = 9600, 1 = 57600, 3 = 1M ...
+  uint8_t  return_delay;        // Return Delay Time register, 2 us units
+  int      usb_latency_us;      // Added before each status packet reaches the host, like a USB-serial latency timer
+  int      jitter_us;           // Uniform random extra delay per status packet
+  double   drop_rate;           // Probability that a status packet is lost
+  double   corrupt_rate;        // Probability that a status packet has a bad CRC
+  bool     check_baud;          // Ignore packets sent at a different baud than the servos use
+  bool     model_wire_time;     // Delay responses by the request and response wire time
+  unsigned seed;
+
+  SimOptions()
+    : first_id(1), last_id(12), baud_index(1), return_delay(250), usb_latency_us(0), jitter_us(0),
+      drop_rate(0.0), corrupt_rate(0.0), check_baud(true), model_wire_time(true), seed(1) { }
+};
+
+struct SimStats
+{
+  uint64_t instruction_packets;
+  uint64_t status_packets;
+  uint64_t sync_write_packets;
+  uint64_t crc_errors;          // Instruction packets with a bad CRC
+  uint64_t ignored_packets;     // Wrong baud, unknown ID or malformed
+  uint64_t dropped_packets;     // Status packets dropped by fault injection
+  uint64_t corrupted_packets;   // Status packets corrupted by fault injection
+};
+
+// One servo: the X-series control table plus a simple position response
+class VirtualServo
+{
+ public:
+  VirtualServo();
+
+  void     reset(uint8_t id, uint8_t baud_index, uint8_t return_delay, bool keep_id_and_baud);
+  void     update(double now);     // Advance Present Position/Velocity to now (s)
+
+  uint8_t  read(uint16_t address, uint16_t length, uint8_t *data, double now);
+  uint8_t  write(uint16_t address, uint16_t length, const uint8_t *data, double now);  // Returns the error number
+
+  uint8_t  getId() { return table_[7]; }
+  uint8_t  getBaudIndex() { return table_[8]; }
+  uint8_t  getReturnDelay() { return table_[9]; }
+  uint8_t  getStatusReturnLevel() { return table_[68]; }
+  void     setHardwareError(uint8_t bits) { table_[70] = bits; }
+  uint8_t  getHardwareError() { return table_[70]; }
+
+  std::vector<uint8_t> registered_;   // REG_WRITE payload: address (2) + data, applied by ACTION
+  bool     no_response_;              // Fault injection: the servo never answers
+
+ private:
+  uint8_t  table_[SIM_CONTROL_TABLE_SIZE];
+  double   position_;                 // Present Position in ticks, fractional
+  double   speed_;                    // ticks/s towards the goal
+  double   last_update_;
+
+  uint16_t mapAddress(uint16_t address);  // Indirect Data -> the control table byte it points at
+  bool     isWritable(uint16_t address);
+  void     startMove(double now);
+  uint32_t get4(uint16_t address);
+  void     set2(uint16_t address, uint16_t value);
+  void     set4(uint16_t address, uint32_t value);
+};
+
+class DxlSimulator
+{
+ public:
+  DxlSimulator(const SimOptions &options);
+  ~DxlSimulator();
+
+  // Creates the pty; link_path (may be NULL) becomes a symlink to its slave side
+  bool         open(const char *link_path);
+  const char  *getPortName() { return port_name_; }
+
+  void         run();               // Serves requests until stop() is called
+  bool         start();             // run() on a background thread
+  void         stop();
+
+  VirtualServo *getServo(uint8_t id);
+  SimStats     getStats() { return stats_; }
+
+ private:
+  SimOptions   options_;
+  VirtualServo servos_[SIM_MAX_SERVOS];
+  bool         present_[SIM_MAX_SERVOS];
+  int          master_fd_;
+  int          slave_fd_;           // Kept open so the pty survives the client closing it
+  char         port_name_[100];
+  char         link_path_[256];
+  volatile bool running_;
+  pthread_t    thread_;
+  bool         thread_started_;
+  SimStats     stats_;
+  uint32_t     random_state_;
+
+  struct PendingStatus
+  {
+    double               ready_time;  // When the packet has fully left its servo
+    std::vector<uint8_t> bytes;
+  };
+
+  std::vector<uint8_t> rx_buffer_;
+  std::vector<PendingStatus> tx_queue_;  // Status packets of the current instruction, in bus order
+  double       tx_ready_time_;      // When the last queued status packet has fully left the servo
+
+  static void *threadMain(void *arg);
+
+  int          getHostBaudrate();
+  bool         servoAtBaudrate(int baudrate);
+  bool         hearsHost(uint8_t id);   // Present and at the host baud, so it decodes the packet
+  double       getByteTime();
+  double       now();
+  double       random01();
+  void         sleepUntil(double time);
+
+  void         processPackets();
+  void         handleInstruction(const uint8_t *packet, uint16_t length);
+  void         queueStatus(uint8_t id, uint8_t error, const uint8_t *params, uint16_t param_length);
+  void         queueFastStatus(const std::vector<uint8_t> &ids, const std::vector<uint16_t> &addresses,
+                               const std::vector<uint16_t> &lengths);
+  void         queuePacket(std::vector<uint8_t> &packet, bool stuffing);
+  void         flushStatus();        // Sends each queued status packet once its ready_time is reached
+  bool         respondsTo(uint8_t id, uint8_t instruction);
+};
+
+#endif // DYNAMIXEL_SDK_SIMULATOR_DXL_SIMULATOR_H_
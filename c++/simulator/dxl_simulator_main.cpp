@@ -0,0 +1,138 @@
+//
+// *********     Virtual Dynamixel Chain      *********
+//
+//
+// Serves a simulated servo chain on a pseudo-terminal until Ctrl+C.
+//
+// Usage: dxl_simulator [--link PATH] [--ids FIRST-LAST] [--baud BPS] [--return-delay-us US]
+//                      [--usb-latency-us US] [--jitter-us US] [--drop P] [--corrupt P]
+//                      [--dead ID] [--hw-error ID:BITS] [--no-wire-time] [--no-baud-check] [--seed N]
+//
+// Point DEVICENAME (or the node's device_name parameter) at the printed port or at --link.
+//
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dxl_simulator.h"
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void onSignal(int)
+{
+  g_stop = 1;
+}
+
+static int baudIndex(int baudrate)
+{
+  static const int baudrates[] = { 9600, 57600, 115200, 1000000, 2000000, 3000000, 4000000, 4500000 };
+  for (int i = 0; i < 8; i++)
+  {
+    if (baudrates[i] == baudrate)
+      return i;
+  }
+  return -1;
+}
+
+static void usage(const char *name)
+{
+  fprintf(stderr,
+          "Usage: %s [--link PATH] [--ids FIRST-LAST] [--baud BPS] [--return-delay-us US]\n"
+          "          [--usb-latency-us US] [--jitter-us US] [--drop P] [--corrupt P]\n"
+          "          [--dead ID] [--hw-error ID:BITS] [--no-wire-time] [--no-baud-check] [--seed N]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+  SimOptions options;
+  const char *link_path = NULL;
+  std::vector<int> dead_ids;
+  std::vector<std::pair<int, int> > hw_errors;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+    bool has_value = true;
+
+    if (strcmp(arg, "--link") == 0 && value)
+      link_path = value;
+    else if (strcmp(arg, "--ids") == 0 && value && sscanf(value, "%d-%d", &options.first_id, &options.last_id) == 2)
+      ;
+    else if (strcmp(arg, "--baud") == 0 && value && baudIndex(atoi(value)) >= 0)
+      options.baud_index = baudIndex(atoi(value));
+    else if (strcmp(arg, "--return-delay-us") == 0 && value)
+      options.return_delay = (uint8_t)(atoi(value) / 2);
+    else if (strcmp(arg, "--usb-latency-us") == 0 && value)
+      options.usb_latency_us = atoi(value);
+    else if (strcmp(arg, "--jitter-us") == 0 && value)
+      options.jitter_us = atoi(value);
+    else if (strcmp(arg, "--drop") == 0 && value)
+      options.drop_rate = atof(value);
+    else if (strcmp(arg, "--corrupt") == 0 && value)
+      options.corrupt_rate = atof(value);
+    else if (strcmp(arg, "--dead") == 0 && value)
+      dead_ids.push_back(atoi(value));
+    else if (strcmp(arg, "--hw-error") == 0 && value && strchr(value, ':'))
+      hw_errors.push_back(std::make_pair(atoi(value), (int)strtol(strchr(value, ':') + 1, NULL, 0)));
+    else if (strcmp(arg, "--seed") == 0 && value)
+      options.seed = (unsigned)atoi(value);
+    else
+    {
+      has_value = false;
+      if (strcmp(arg, "--no-wire-time") == 0)
+        options.model_wire_time = false;
+      else if (strcmp(arg, "--no-baud-check") == 0)
+        options.check_baud = false;
+      else
+      {
+        usage(argv[0]);
+        return 1;
+      }
+    }
+    if (has_value)
+      i++;
+  }
+  if (options.first_id < 0 || options.last_id >= SIM_MAX_SERVOS || options.first_id > options.last_id)
+  {
+    fprintf(stderr, "Invalid ID range %d-%d\n", options.first_id, options.last_id);
+    return 1;
+  }
+
+  DxlSimulator simulator(options);
+  if (!simulator.open(link_path))
+    return 1;
+  for (size_t i = 0; i < dead_ids.size(); i++)
+  {
+    if (simulator.getServo(dead_ids[i]))
+      simulator.getServo(dead_ids[i])->no_response_ = true;
+  }
+  for (size_t i = 0; i < hw_errors.size(); i++)
+  {
+    if (simulator.getServo(hw_errors[i].first))
+      simulator.getServo(hw_errors[i].first)->setHardwareError(hw_errors[i].second);
+  }
+
+  printf("Simulating IDs %d-%d on %s%s%s\n", options.first_id, options.last_id, simulator.getPortName(),
+         link_path ? " -> " : "", link_path ? link_path : "");
+  fflush(stdout);
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  if (!simulator.start())
+    return 1;
+  while (!g_stop)
+    pause();
+  simulator.stop();
+
+  SimStats stats = simulator.getStats();
+  printf("\ninstructions: %llu  status: %llu  sync writes: %llu  crc errors: %llu  ignored: %llu  dropped: %llu  corrupted: %llu\n",
+         (unsigned long long)stats.instruction_packets, (unsigned long long)stats.status_packets,
+         (unsigned long long)stats.sync_write_packets,
+         (unsigned long long)stats.crc_errors, (unsigned long long)stats.ignored_packets,
+         (unsigned long long)stats.dropped_packets, (unsigned long long)stats.corrupted_packets);
+  return 0;
+}
@@ -36,6 +36,11 @@ GroupBulkRead::GroupBulkRead(PortHandler *port, PacketHandler *ph)
   : GroupHandler(port, ph),
     last_result_(false)
 {
+  for (int id = 0; id < 256; id++)
+  {
+    address_list_[id] = 0;
+    error_list_[id]   = 0;
+  }
   clearParam();
 }
 
@@ -63,31 +68,28 @@ void GroupBulkRead::makeParam()
     uint8_t id = id_list_[i];
     if (ph_->getProtocolVersion() == 1.0)
     {
-      param_[idx++] = (uint8_t)length_list_[id];    // LEN
+      param_[idx++] = (uint8_t)data_length_list_[id];  // LEN
       param_[idx++] = id;                           // ID
-      param_[idx++] = (uint8_t)address_list_[id];   // ADDR
+      param_[idx++] = (uint8_t)address_list_[id];       // ADDR
     }
     else    // 2.0
     {
       param_[idx++] = id;                               // ID
       param_[idx++] = DXL_LOBYTE(address_list_[id]);    // ADDR_L
       param_[idx++] = DXL_HIBYTE(address_list_[id]);    // ADDR_H
-      param_[idx++] = DXL_LOBYTE(length_list_[id]);     // LEN_L
-      param_[idx++] = DXL_HIBYTE(length_list_[id]);     // LEN_H
+      param_[idx++] = DXL_LOBYTE(data_length_list_[id]);  // LEN_L
+      param_[idx++] = DXL_HIBYTE(data_length_list_[id]);  // LEN_H
     }
   }
 }
 
 bool GroupBulkRead::addParam(uint8_t id, uint16_t start_address, uint16_t data_length)
 {
-  if (std::find(id_list_.begin(), id_list_.end(), id) != id_list_.end())   // id already exist
+  if (addDataSlot(id, data_length) == false)   // id already exist
     return false;
 
-  id_list_.push_back(id);
-  length_list_[id]    = data_length;
   address_list_[id]   = start_address;
-  data_list_[id]      = new uint8_t[data_length];
-  error_list_[id]     = new uint8_t[1];
+  error_list_[id]     = 0;
 
   is_param_changed_   = true;
   return true;
@@ -95,18 +97,9 @@ bool GroupBulkRead::addParam(uint8_t id, uint16_t start_address, uint16_t data_l
 
 void GroupBulkRead::removeParam(uint8_t id)
 {
-  std::vector<uint8_t>::iterator it = std::find(id_list_.begin(), id_list_.end(), id);
-  if (it == id_list_.end())    // NOT exist
+  if (removeDataSlot(id) == false)    // NOT exist
     return;
 
-  id_list_.erase(it);
-  address_list_.erase(id);
-  length_list_.erase(id);
-  delete[] data_list_[id];
-  delete[] error_list_[id];
-  data_list_.erase(id);
-  error_list_.erase(id);
-
   is_param_changed_   = true;
 }
 
@@ -115,17 +108,7 @@ void GroupBulkRead::clearParam()
   if (id_list_.size() == 0)
     return;
 
-  for (unsigned int i = 0; i < id_list_.size(); i++)
-  {
-    delete[] data_list_[id_list_[i]];
-    delete[] error_list_[id_list_[i]];
-  }
-
-  id_list_.clear();
-  address_list_.clear();
-  length_list_.clear();
-  data_list_.clear();
-  error_list_.clear();
+  clearDataSlots();
   if (param_ != 0)
     delete[] param_;
   param_ = 0;
@@ -163,7 +146,7 @@ int GroupBulkRead::rxPacket()
   {
     uint8_t id = id_list_[i];
 
-    result = ph_->readRx(port_, id, length_list_[id], data_list_[id], error_list_[id]);
+    result = ph_->readRx(port_, id, data_length_list_[id], getDataPointer(id), &error_list_[id]);
     if (result != COMM_SUCCESS)
       return result;
   }
@@ -189,12 +172,12 @@ bool GroupBulkRead::isAvailable(uint8_t id, uint16_t address, uint16_t data_leng
 {
   uint16_t start_addr;
 
-  if (last_result_ == false || data_list_.find(id) == data_list_.end())
+  if (last_result_ == false || isListed(id) == false)
     return false;
 
   start_addr = address_list_[id];
 
-  if (address < start_addr || start_addr + length_list_[id] - data_length < address)
+  if (address < start_addr || start_addr + data_length_list_[id] - data_length < address)
     return false;
 
   return true;
@@ -205,19 +188,18 @@ uint32_t GroupBulkRead::getData(uint8_t id, uint16_t address, uint16_t data_leng
   if (isAvailable(id, address, data_length) == false)
     return 0;
 
-  uint16_t start_addr = address_list_[id];
+  uint8_t *data = getDataPointer(id) + (address - address_list_[id]);
 
   switch(data_length)
   {
     case 1:
-      return data_list_[id][address - start_addr];
+      return data[0];
 
     case 2:
-      return DXL_MAKEWORD(data_list_[id][address - start_addr], data_list_[id][address - start_addr + 1]);
+      return DXL_MAKEWORD(data[0], data[1]);
 
     case 4:
-      return DXL_MAKEDWORD(DXL_MAKEWORD(data_list_[id][address - start_addr + 0], data_list_[id][address - start_addr + 1]),
-                           DXL_MAKEWORD(data_list_[id][address - start_addr + 2], data_list_[id][address - start_addr + 3]));
+      return DXL_MAKEDWORD(DXL_MAKEWORD(data[0], data[1]), DXL_MAKEWORD(data[2], data[3]));
 
     default:
       return 0;
@@ -229,5 +211,5 @@ bool GroupBulkRead::getError(uint8_t id, uint8_t* error)
   // TODO : check protocol version, last_result_, data_list
   // if (last_result_ == false || error_list_.find(id) == error_list_.end())
 
-  return error[0] = error_list_[id][0];
+  return (error[0] = error_list_[id]);
 }
@@ -17,6 +17,7 @@
 /* Author: zerom, Ryu Woon Jung (Leon) */
 
 #include <algorithm>
+#include <string.h>
 
 #if defined(__linux__)
 #include "group_bulk_write.h"
@@ -32,42 +33,25 @@
 using namespace dynamixel;
 
 GroupBulkWrite::GroupBulkWrite(PortHandler *port, PacketHandler *ph)
-  : GroupHandler(port, ph),
-    param_length_(0)
+  : GroupHandler(port, ph)
 {
+  for (int id = 0; id < 256; id++)
+    address_list_[id] = 0;
   clearParam();
 }
 
-void GroupBulkWrite::makeParam()
+// data_list_ holds the parameters as they are sent:
+// ID(1) + ADDR(2) + LENGTH(2) + DATA(data_length) for each ID
+void GroupBulkWrite::setSlotHeader(uint8_t id, uint16_t start_address, uint16_t data_length)
 {
-  if (ph_->getProtocolVersion() == 1.0 || id_list_.size() == 0)
-    return;
-
-  if (param_ != 0)
-    delete[] param_;
-  param_ = 0;
-
-  param_length_ = 0;
-  for (unsigned int i = 0; i < id_list_.size(); i++)
-    param_length_ += 1 + 2 + 2 + length_list_[id_list_[i]];
-
-  param_ = new uint8_t[param_length_];
-
-  int idx = 0;
-  for (unsigned int i = 0; i < id_list_.size(); i++)
-  {
-    uint8_t id = id_list_[i];
-    if (data_list_[id] == 0)
-      return;
-
-    param_[idx++] = id;
-    param_[idx++] = DXL_LOBYTE(address_list_[id]);
-    param_[idx++] = DXL_HIBYTE(address_list_[id]);
-    param_[idx++] = DXL_LOBYTE(length_list_[id]);
-    param_[idx++] = DXL_HIBYTE(length_list_[id]);
-    for (int c = 0; c < length_list_[id]; c++)
-      param_[idx++] = (data_list_[id])[c];
-  }
+  uint8_t *param = getDataPointer(id);
+
+  param[0] = id;
+  param[1] = DXL_LOBYTE(start_address);
+  param[2] = DXL_HIBYTE(start_address);
+  param[3] = DXL_LOBYTE(data_length);
+  param[4] = DXL_HIBYTE(data_length);
+  address_list_[id] = start_address;
 }
 
 bool GroupBulkWrite::addParam(uint8_t id, uint16_t start_address, uint16_t data_length, uint8_t *data)
@@ -75,17 +59,11 @@ bool GroupBulkWrite::addParam(uint8_t id, uint16_t start_address, uint16_t data_
   if (ph_->getProtocolVersion() == 1.0)
     return false;
 
-  if (std::find(id_list_.begin(), id_list_.end(), id) != id_list_.end())   // id already exist
+  if (addDataSlot(id, 5 + data_length) == false)   // id already exist
     return false;
 
-  id_list_.push_back(id);
-  address_list_[id]   = start_address;
-  length_list_[id]    = data_length;
-  data_list_[id]      = new uint8_t[data_length];
-  for (int c = 0; c < data_length; c++)
-    data_list_[id][c] = data[c];
-
-  is_param_changed_   = true;
+  setSlotHeader(id, start_address, data_length);
+  memcpy(getDataPointer(id) + 5, data, data_length);
   return true;
 }
 void GroupBulkWrite::removeParam(uint8_t id)
@@ -93,35 +71,22 @@ void GroupBulkWrite::removeParam(uint8_t id)
   if (ph_->getProtocolVersion() == 1.0)
     return;
 
-  std::vector<uint8_t>::iterator it = std::find(id_list_.begin(), id_list_.end(), id);
-  if (it == id_list_.end())    // NOT exist
-    return;
-
-  id_list_.erase(it);
-  address_list_.erase(id);
-  length_list_.erase(id);
-  delete[] data_list_[id];
-  data_list_.erase(id);
-
-  is_param_changed_   = true;
+  removeDataSlot(id);
 }
 bool GroupBulkWrite::changeParam(uint8_t id, uint16_t start_address, uint16_t data_length, uint8_t *data)
 {
   if (ph_->getProtocolVersion() == 1.0)
     return false;
 
-  std::vector<uint8_t>::iterator it = std::find(id_list_.begin(), id_list_.end(), id);
-  if (it == id_list_.end())    // NOT exist
+  if (isListed(id) == false)    // NOT exist
     return false;
 
-  address_list_[id]   = start_address;
-  length_list_[id]    = data_length;
-  delete[] data_list_[id];
-  data_list_[id]      = new uint8_t[data_length];
-  for (int c = 0; c < data_length; c++)
-    data_list_[id][c] = data[c];
-
-  is_param_changed_   = true;
+  if (address_list_[id] != start_address || data_length_list_[id] != 5 + data_length)
+  {
+    resizeDataSlot(id, 5 + data_length);
+    setSlotHeader(id, start_address, data_length);
+  }
+  memcpy(getDataPointer(id) + 5, data, data_length);  // only the data bytes, in place
   return true;
 }
 void GroupBulkWrite::clearParam()
@@ -129,24 +94,12 @@ void GroupBulkWrite::clearParam()
   if (ph_->getProtocolVersion() == 1.0 || id_list_.size() == 0)
     return;
 
-  for (unsigned int i = 0; i < id_list_.size(); i++)
-    delete[] data_list_[id_list_[i]];
-
-  id_list_.clear();
-  address_list_.clear();
-  length_list_.clear();
-  data_list_.clear();
-  if (param_ != 0)
-    delete[] param_;
-  param_ = 0;
+  clearDataSlots();
 }
 int GroupBulkWrite::txPacket()
 {
   if (ph_->getProtocolVersion() == 1.0 || id_list_.size() == 0)
     return COMM_NOT_AVAILABLE;
 
-  if (is_param_changed_ == true || param_ == 0)
-    makeParam();
-
-  return ph_->bulkWriteTxOnly(port_, param_, param_length_);
+  return ph_->bulkWriteTxOnly(port_, &data_list_[0], data_list_.size());
 }
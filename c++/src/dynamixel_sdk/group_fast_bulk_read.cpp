@@ -17,6 +17,8 @@
 /* Author: Honghyun Kim */
 
 #include <algorithm>
+#include <stdlib.h>
+#include <string.h>
 
 #if defined(__linux__)
 #include "group_fast_bulk_read.h"
@@ -58,8 +60,8 @@ void GroupFastBulkRead::makeParam()
         param_[idx++] = id;                               // ID
         param_[idx++] = DXL_LOBYTE(address_list_[id]);    // ADDR_L
         param_[idx++] = DXL_HIBYTE(address_list_[id]);    // ADDR_H
-        param_[idx++] = DXL_LOBYTE(length_list_[id]);     // LEN_L
-        param_[idx++] = DXL_HIBYTE(length_list_[id]);     // LEN_H
+        param_[idx++] = DXL_LOBYTE(data_length_list_[id]);  // LEN_L
+        param_[idx++] = DXL_HIBYTE(data_length_list_[id]);  // LEN_H
     }
 }
 
@@ -83,7 +85,9 @@ int GroupFastBulkRead::rxPacket()
 
     int count = id_list_.size();
     int result = COMM_RX_FAIL;
-    uint8_t *rxpacket = (uint8_t *)malloc(RXPACKET_MAX_LEN);
+    uint8_t *rxpacket = port_->getRxPacketBuffer();
+    if (NULL == rxpacket)
+        rxpacket = (uint8_t *)malloc(RXPACKET_MAX_LEN);  // the port keeps no buffer of its own
     if (NULL == rxpacket)
         return result;
 
@@ -95,17 +99,16 @@ int GroupFastBulkRead::rxPacket()
         int index = PKT_PARAMETER0;
         for (int i = 0; i < count; ++i) {
             uint8_t id = id_list_[i];
-            uint16_t length = length_list_[id];
-            *error_list_[id] = (uint8_t)rxpacket[index];
-            for (uint16_t s = 0; s < length; s++) {
-                data_list_[id][s] = rxpacket[index + 2 + s];
-            }
+            uint16_t length = data_length_list_[id];
+            error_list_[id] = (uint8_t)rxpacket[index];
+            memcpy(getDataPointer(id), &rxpacket[index + 2], length);
             index += (length + 4);
         }
         last_result_ = true;
     }
 
-    free(rxpacket);
+    if (port_->getRxPacketBuffer() != rxpacket)
+        free(rxpacket);
     return result;
 }
 
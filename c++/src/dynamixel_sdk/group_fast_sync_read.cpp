@@ -17,6 +17,8 @@
 /* Author: Honghyun Kim */
 
 #include <algorithm>
+#include <stdlib.h>
+#include <string.h>
 
 #if defined(__linux__)
 #include "group_fast_sync_read.h"
@@ -61,7 +63,9 @@ int GroupFastSyncRead::rxPacket()
 
     int count = id_list_.size();
     int result = COMM_RX_FAIL;
-    uint8_t *rxpacket = (uint8_t *)malloc(RXPACKET_MAX_LEN);
+    uint8_t *rxpacket = port_->getRxPacketBuffer();
+    if (NULL == rxpacket)
+        rxpacket = (uint8_t *)malloc(RXPACKET_MAX_LEN);  // the port keeps no buffer of its own
     if (NULL == rxpacket)
         return result;
 
@@ -73,16 +77,15 @@ int GroupFastSyncRead::rxPacket()
         int index = PKT_PARAMETER0;
         for (int i = 0; i < count; ++i) {
             uint8_t id = id_list_[i];
-            *error_list_[id] = (uint8_t)rxpacket[index];
-            for (uint16_t s = 0; s < data_length_; s++) {
-                data_list_[id][s] = rxpacket[index + 2 + s];
-            }
+            error_list_[id] = (uint8_t)rxpacket[index];
+            memcpy(getDataPointer(id), &rxpacket[index + 2], data_length_);
             index += (data_length_ + 4);
         }
         last_result_ = true;
     }
 
-    free(rxpacket);
+    if (port_->getRxPacketBuffer() != rxpacket)
+        free(rxpacket);
     return result;
 }
 
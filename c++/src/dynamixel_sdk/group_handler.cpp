@@ -16,6 +16,8 @@
 
 /* Author: Honghyun Kim */
 
+#include <algorithm>
+
 #if defined(__linux__)
 #include "group_handler.h"
 #elif defined(__APPLE__)
@@ -35,5 +37,78 @@ GroupHandler::GroupHandler(PortHandler *port, PacketHandler *ph)
    is_param_changed_(false),
    param_(0)
 {
+    for (int id = 0; id < 256; id++)
+    {
+        data_offset_list_[id] = NOT_LISTED_;
+        data_length_list_[id] = 0;
+    }
+}
+
+// Appends id to id_list_ and reserves data_length bytes for it at the end of data_list_.
+bool GroupHandler::addDataSlot(uint8_t id, uint16_t data_length)
+{
+    if (isListed(id))   // id already exist
+        return false;
+
+    id_list_.push_back(id);
+    data_offset_list_[id] = data_list_.size();
+    data_length_list_[id] = data_length;
+    data_list_.resize(data_list_.size() + data_length);
+    return true;
+}
+
+// Removes id from id_list_ and closes the gap its data leaves in data_list_.
+bool GroupHandler::removeDataSlot(uint8_t id)
+{
+    if (!isListed(id))  // NOT exist
+        return false;
+
+    uint16_t offset = data_offset_list_[id];
+    uint16_t length = data_length_list_[id];
+
+    id_list_.erase(std::find(id_list_.begin(), id_list_.end(), id));
+    data_list_.erase(data_list_.begin() + offset, data_list_.begin() + offset + length);
+    data_offset_list_[id] = NOT_LISTED_;
+    data_length_list_[id] = 0;
+
+    for (unsigned int i = 0; i < id_list_.size(); i++)
+    {
+        if (data_offset_list_[id_list_[i]] > offset)
+            data_offset_list_[id_list_[i]] -= length;
+    }
+    return true;
+}
+
+// Changes the data length of a listed id, moving the data of the IDs behind it.
+void GroupHandler::resizeDataSlot(uint8_t id, uint16_t data_length)
+{
+    uint16_t offset = data_offset_list_[id];
+    uint16_t length = data_length_list_[id];
+
+    if (data_length == length)
+        return;
+
+    if (data_length > length)
+        data_list_.insert(data_list_.begin() + offset + length, data_length - length, 0);
+    else
+        data_list_.erase(data_list_.begin() + offset + data_length, data_list_.begin() + offset + length);
+    data_length_list_[id] = data_length;
+
+    for (unsigned int i = 0; i < id_list_.size(); i++)
+    {
+        if (data_offset_list_[id_list_[i]] > offset)
+            data_offset_list_[id_list_[i]] += data_length - length;
+    }
+}
+
+void GroupHandler::clearDataSlots()
+{
+    for (unsigned int i = 0; i < id_list_.size(); i++)
+    {
+        data_offset_list_[id_list_[i]] = NOT_LISTED_;
+        data_length_list_[id_list_[i]] = 0;
+    }
 
+    id_list_.clear();
+    data_list_.clear();
 }
@@ -37,6 +37,8 @@ GroupSyncRead::GroupSyncRead(PortHandler *port, PacketHandler *ph, uint16_t star
     start_address_(start_address),
     data_length_(data_length)
 {
+  for (int id = 0; id < 256; id++)
+    error_list_[id] = 0;
   clearParam();
 }
 
@@ -61,12 +63,10 @@ bool GroupSyncRead::addParam(uint8_t id)
   if (ph_->getProtocolVersion() == 1.0)
     return false;
 
-  if (std::find(id_list_.begin(), id_list_.end(), id) != id_list_.end())   // id already exist
+  if (addDataSlot(id, data_length_) == false)   // id already exist
     return false;
 
-  id_list_.push_back(id);
-  data_list_[id] = new uint8_t[data_length_];
-  error_list_[id] = new uint8_t[1];
+  error_list_[id] = 0;
 
   is_param_changed_   = true;
   return true;
@@ -76,16 +76,9 @@ void GroupSyncRead::removeParam(uint8_t id)
   if (ph_->getProtocolVersion() == 1.0)
     return;
 
-  std::vector<uint8_t>::iterator it = std::find(id_list_.begin(), id_list_.end(), id);
-  if (it == id_list_.end())    // NOT exist
+  if (removeDataSlot(id) == false)    // NOT exist
     return;
 
-  id_list_.erase(it);
-  delete[] data_list_[id];
-  delete[] error_list_[id];
-  data_list_.erase(id);
-  error_list_.erase(id);
-
   is_param_changed_   = true;
 }
 void GroupSyncRead::clearParam()
@@ -93,15 +86,7 @@ void GroupSyncRead::clearParam()
   if (ph_->getProtocolVersion() == 1.0 || id_list_.size() == 0)
     return;
 
-  for (unsigned int i = 0; i < id_list_.size(); i++)
-  {
-    delete[] data_list_[id_list_[i]];
-    delete[] error_list_[id_list_[i]];
-  }
-
-  id_list_.clear();
-  data_list_.clear();
-  error_list_.clear();
+  clearDataSlots();
   if (param_ != 0)
     delete[] param_;
   param_ = 0;
@@ -135,7 +120,7 @@ int GroupSyncRead::rxPacket()
   {
     uint8_t id = id_list_[i];
 
-    result = ph_->readRx(port_, id, data_length_, data_list_[id], error_list_[id]);
+    result = ph_->readRx(port_, id, data_length_, getDataPointer(id), &error_list_[id]);
     if (result != COMM_SUCCESS)
       return result;
   }
@@ -162,7 +147,7 @@ int GroupSyncRead::txRxPacket()
 
 bool GroupSyncRead::isAvailable(uint8_t id, uint16_t address, uint16_t data_length)
 {
-  if (ph_->getProtocolVersion() == 1.0 || last_result_ == false || data_list_.find(id) == data_list_.end())
+  if (ph_->getProtocolVersion() == 1.0 || last_result_ == false || isListed(id) == false)
     return false;
 
   if (address < start_address_ || start_address_ + data_length_ - data_length < address)
@@ -176,17 +161,18 @@ uint32_t GroupSyncRead::getData(uint8_t id, uint16_t address, uint16_t data_leng
   if (isAvailable(id, address, data_length) == false)
     return 0;
 
+  uint8_t *data = getDataPointer(id) + (address - start_address_);
+
   switch(data_length)
   {
     case 1:
-      return data_list_[id][address - start_address_];
+      return data[0];
 
     case 2:
-      return DXL_MAKEWORD(data_list_[id][address - start_address_], data_list_[id][address - start_address_ + 1]);
+      return DXL_MAKEWORD(data[0], data[1]);
 
     case 4:
-      return DXL_MAKEDWORD(DXL_MAKEWORD(data_list_[id][address - start_address_ + 0], data_list_[id][address - start_address_ + 1]),
-                 DXL_MAKEWORD(data_list_[id][address - start_address_ + 2], data_list_[id][address - start_address_ + 3]));
+      return DXL_MAKEDWORD(DXL_MAKEWORD(data[0], data[1]), DXL_MAKEWORD(data[2], data[3]));
 
     default:
       return 0;
@@ -198,5 +184,5 @@ bool GroupSyncRead::getError(uint8_t id, uint8_t* error)
   // TODO : check protocol version, last_result_, data_list
   // if (ph_->getProtocolVersion() == 1.0 || last_result_ == false || error_list_.find(id) == error_list_.end())
 
-  return error[0] = error_list_[id][0];
+  return (error[0] = error_list_[id]);
 }
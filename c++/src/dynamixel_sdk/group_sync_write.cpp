@@ -17,6 +17,7 @@
 /* Author: zerom, Ryu Woon Jung (Leon) */
 
 #include <algorithm>
+#include <string.h>
 
 #if defined(__linux__)
 #include "group_sync_write.h"
@@ -39,68 +40,29 @@ GroupSyncWrite::GroupSyncWrite(PortHandler *port, PacketHandler *ph, uint16_t st
   clearParam();
 }
 
-void GroupSyncWrite::makeParam()
-{
-  if (id_list_.size() == 0) return;
-
-  if (param_ != 0)
-    delete[] param_;
-  param_ = 0;
-
-  param_ = new uint8_t[id_list_.size() * (1 + data_length_)]; // ID(1) + DATA(data_length)
-
-  int idx = 0;
-  for (unsigned int i = 0; i < id_list_.size(); i++)
-  {
-    uint8_t id = id_list_[i];
-    if (data_list_[id] == 0)
-      return;
-
-    param_[idx++] = id;
-    for (int c = 0; c < data_length_; c++)
-      param_[idx++] = (data_list_[id])[c];
-  }
-}
-
 bool GroupSyncWrite::addParam(uint8_t id, uint8_t *data)
 {
-  if (std::find(id_list_.begin(), id_list_.end(), id) != id_list_.end())   // id already exist
+  // data_list_ holds the parameters as they are sent: ID(1) + DATA(data_length) for each ID
+  if (addDataSlot(id, 1 + data_length_) == false)   // id already exist
     return false;
 
-  id_list_.push_back(id);
-  data_list_[id]    = new uint8_t[data_length_];
-  for (int c = 0; c < data_length_; c++)
-    data_list_[id][c] = data[c];
-
-  is_param_changed_   = true;
+  uint8_t *param = getDataPointer(id);
+  param[0] = id;
+  memcpy(&param[1], data, data_length_);
   return true;
 }
 
 void GroupSyncWrite::removeParam(uint8_t id)
 {
-  std::vector<uint8_t>::iterator it = std::find(id_list_.begin(), id_list_.end(), id);
-  if (it == id_list_.end())    // NOT exist
-    return;
-
-  id_list_.erase(it);
-  delete[] data_list_[id];
-  data_list_.erase(id);
-
-  is_param_changed_   = true;
+  removeDataSlot(id);
 }
 
 bool GroupSyncWrite::changeParam(uint8_t id, uint8_t *data)
 {
-  std::vector<uint8_t>::iterator it = std::find(id_list_.begin(), id_list_.end(), id);
-  if (it == id_list_.end())    // NOT exist
+  if (isListed(id) == false)    // NOT exist
     return false;
 
-  delete[] data_list_[id];
-  data_list_[id]    = new uint8_t[data_length_];
-  for (int c = 0; c < data_length_; c++)
-    data_list_[id][c] = data[c];
-
-  is_param_changed_   = true;
+  memcpy(getDataPointer(id) + 1, data, data_length_);  // only the data bytes, in place
   return true;
 }
 
@@ -109,14 +71,7 @@ void GroupSyncWrite::clearParam()
   if (id_list_.size() == 0)
     return;
 
-  for (unsigned int i = 0; i < id_list_.size(); i++)
-    delete[] data_list_[id_list_[i]];
-
-  id_list_.clear();
-  data_list_.clear();
-  if (param_ != 0)
-    delete[] param_;
-  param_ = 0;
+  clearDataSlots();
 }
 
 int GroupSyncWrite::txPacket()
@@ -124,8 +79,5 @@ int GroupSyncWrite::txPacket()
   if (id_list_.size() == 0)
     return COMM_NOT_AVAILABLE;
 
-  if (is_param_changed_ == true || param_ == 0)
-    makeParam();
-
-  return ph_->syncWriteTxOnly(port_, start_address_, data_length_, param_, id_list_.size() * (1 + data_length_));
+  return ph_->syncWriteTxOnly(port_, start_address_, data_length_, &data_list_[0], data_list_.size());
 }
@@ -19,10 +19,14 @@
 #if defined(__linux__)
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
 #include <string.h>
 #include <unistd.h>
 #include <termios.h>
+#include <poll.h>
 #include <time.h>
 #include <sys/time.h>
 #include <sys/ioctl.h>
@@ -30,30 +34,18 @@
 
 #include "port_handler_linux.h"
 
-#define LATENCY_TIMER  16  // msec (USB latency timer)
-                           // You should adjust the latency timer value. From the version Ubuntu 16.04.2, the default latency timer of the usb serial is '16 msec'.
-                           // When you are going to use sync / bulk read, the latency timer should be loosen.
-                           // the lower latency timer value, the faster communication speed.
-
-                           // Note:
-                           // You can check its value by:
-                           // $ cat /sys/bus/usb-serial/devices/ttyUSB0/latency_timer
-                           //
-                           // If you think that the communication is too slow, type following after plugging the usb in to change the latency timer
-                           //
-                           // Method 1. Type following (you should do this everytime when the usb once was plugged out or the connection was dropped)
-                           // $ echo 1 | sudo tee /sys/bus/usb-serial/devices/ttyUSB0/latency_timer
-                           // $ cat /sys/bus/usb-serial/devices/ttyUSB0/latency_timer
-                           //
-                           // Method 2. If you want to set it as be done automatically, and don't want to do above everytime, make rules file in /etc/udev/rules.d/. For example,
-                           // $ echo ACTION==\"add\", SUBSYSTEM==\"usb-serial\", DRIVER==\"ftdi_sio\", ATTR{latency_timer}=\"1\" > 99-dynamixelsdk-usb.rules
-                           // $ sudo cp ./99-dynamixelsdk-usb.rules /etc/udev/rules.d/
-                           // $ sudo udevadm control --reload-rules
-                           // $ sudo udevadm trigger --action=add
-                           // $ cat /sys/bus/usb-serial/devices/ttyUSB0/latency_timer
-                           //
-                           // or if you have another good idea that can be an alternatives,
-                           // please give us advice via github issue https://github.com/ROBOTIS-GIT/DynamixelSDK/issues
+#define DEFAULT_LATENCY_TIMER  16  // msec, assumed when the port has no readable latency_timer (the ftdi_sio default)
+#define LOW_LATENCY_TIMER       1  // msec, requested from USB-serial adapters
+
+// The USB-serial driver holds received bytes for up to latency_timer msec before passing them on,
+// so each status packet costs up to that much. openPort() sets ASYNC_LOW_LATENCY, which ftdi_sio
+// turns into a 1 msec latency timer without root, falls back to writing
+// /sys/bus/usb-serial/devices/<tty>/latency_timer, and times packets out with the value it reads back.
+// If neither is permitted, a udev rule still works:
+// $ echo ACTION==\"add\", SUBSYSTEM==\"usb-serial\", DRIVER==\"ftdi_sio\", ATTR{latency_timer}=\"1\" > 99-dynamixelsdk-usb.rules
+// $ sudo cp ./99-dynamixelsdk-usb.rules /etc/udev/rules.d/
+// $ sudo udevadm control --reload-rules
+// $ sudo udevadm trigger --action=add
 
 struct termios2 {
   tcflag_t c_iflag;       /* input mode flags */
@@ -81,9 +73,14 @@ using namespace dynamixel;
 PortHandlerLinux::PortHandlerLinux(const char *port_name)
   : socket_fd_(-1),
     baudrate_(DEFAULT_BAUDRATE_),
-    packet_start_time_(0.0),
-    packet_timeout_(0.0),
-    tx_time_per_byte(0.0)
+    packet_start_time_ns_(0),
+    packet_timeout_ns_(0),
+    tx_start_time_ns_(0),
+    first_byte_time_ns_(0),
+    last_byte_time_ns_(0),
+    tx_time_per_byte(0.0),
+    latency_timer_(DEFAULT_LATENCY_TIMER),
+    blocking_read_(true)
 {
   is_using_ = false;
   setPortName(port_name);
@@ -91,7 +88,13 @@ PortHandlerLinux::PortHandlerLinux(const char *port_name)
 
 bool PortHandlerLinux::openPort()
 {
-  return setBaudRate(baudrate_);
+  if (!setBaudRate(baudrate_))
+    return false;
+
+  // The adapter keeps these settings until it is unplugged, so later setBaudRate() calls,
+  // which reopen the port, do not need to repeat them
+  setLowLatency();
+  return true;
 }
 
 void PortHandlerLinux::closePort()
@@ -150,52 +153,128 @@ int PortHandlerLinux::getBytesAvailable()
 
 int PortHandlerLinux::readPort(uint8_t *packet, int length)
 {
-  return read(socket_fd_, packet, length);
+  if (blocking_read_)
+    waitReadable();
+
+  int result = read(socket_fd_, packet, length);
+  if (result > 0)
+  {
+    last_byte_time_ns_ = getCurrentTimeNs();
+    if (first_byte_time_ns_ == 0)
+      first_byte_time_ns_ = last_byte_time_ns_;
+  }
+  return result;
+}
+
+int PortHandlerLinux::getLatencyTimer()
+{
+  return latency_timer_;
+}
+
+void PortHandlerLinux::setBlockingRead(bool blocking)
+{
+  blocking_read_ = blocking;
+}
+
+bool PortHandlerLinux::getBlockingRead()
+{
+  return blocking_read_;
 }
 
 int PortHandlerLinux::writePort(uint8_t *packet, int length)
 {
+  // A new transaction: the bytes read from here on are its response
+  tx_start_time_ns_   = getCurrentTimeNs();
+  first_byte_time_ns_ = 0;
+  last_byte_time_ns_  = 0;
   return write(socket_fd_, packet, length);
 }
 
 void PortHandlerLinux::setPacketTimeout(uint16_t packet_length)
 {
-  packet_start_time_  = getCurrentTime();
-  packet_timeout_     = (tx_time_per_byte * (double)packet_length) + (LATENCY_TIMER * 2.0) + 2.0;
+  packet_start_time_ns_ = getCurrentTimeNs();
+  packet_timeout_ns_    = (int64_t)(((tx_time_per_byte * (double)packet_length) + (latency_timer_ * 2.0) + 2.0) * 1000000.0);
 }
 
 void PortHandlerLinux::setPacketTimeout(double msec)
 {
-  packet_start_time_  = getCurrentTime();
-  packet_timeout_     = msec;
+  packet_start_time_ns_ = getCurrentTimeNs();
+  packet_timeout_ns_    = (int64_t)(msec * 1000000.0);
 }
 
 bool PortHandlerLinux::isPacketTimeout()
 {
-  if(getTimeSinceStart() > packet_timeout_)
+  if(getTimeSinceStart() > packet_timeout_ns_)
   {
-    packet_timeout_ = 0;
+    packet_timeout_ns_ = 0;
     return true;
   }
   return false;
 }
 
-double PortHandlerLinux::getCurrentTime()
+int64_t PortHandlerLinux::getCurrentTimeNs()
+{
+  // Not slewed or stepped by NTP, so a timeout is never cut short or stretched
+  struct timespec tv;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &tv);
+  return (int64_t)tv.tv_sec * 1000000000LL + tv.tv_nsec;
+}
+
+int64_t PortHandlerLinux::getTxStartTime()
+{
+  return tx_start_time_ns_;
+}
+
+int64_t PortHandlerLinux::getFirstByteTime()
+{
+  return first_byte_time_ns_;
+}
+
+int64_t PortHandlerLinux::getLastByteTime()
+{
+  return last_byte_time_ns_;
+}
+
+uint8_t *PortHandlerLinux::getTxPacketBuffer()
 {
-	struct timespec tv;
-	clock_gettime(CLOCK_REALTIME, &tv);
-	return ((double)tv.tv_sec * 1000.0 + (double)tv.tv_nsec * 0.001 * 0.001);
+  return tx_packet_;
 }
 
-double PortHandlerLinux::getTimeSinceStart()
+uint8_t *PortHandlerLinux::getTxStuffedPacketBuffer()
 {
-  double time;
+  return tx_stuffed_packet_;
+}
 
-  time = getCurrentTime() - packet_start_time_;
-  if(time < 0.0)
-    packet_start_time_ = getCurrentTime();
+uint8_t *PortHandlerLinux::getRxPacketBuffer()
+{
+  return rx_packet_;
+}
 
-  return time;
+int64_t PortHandlerLinux::getTimeSinceStart()
+{
+  return getCurrentTimeNs() - packet_start_time_ns_;
+}
+
+// Sleeps until the port has a byte to read or the packet timeout expires.
+// Without an armed timeout (or once it has expired) this returns at once,
+// so a readPort() outside of a packet transaction never blocks.
+void PortHandlerLinux::waitReadable()
+{
+  int64_t remaining = packet_timeout_ns_ - getTimeSinceStart();
+  if (remaining <= 0)
+    return;
+
+  struct pollfd pfd;
+  pfd.fd      = socket_fd_;
+  pfd.events  = POLLIN;
+  pfd.revents = 0;
+
+  struct timespec timeout;
+  timeout.tv_sec  = (time_t)(remaining / 1000000000LL);
+  timeout.tv_nsec = (long)(remaining % 1000000000LL);
+
+  // EINTR and errors fall through to read(), which reports them as before
+  ppoll(&pfd, 1, &timeout, NULL);
 }
 
 bool PortHandlerLinux::setupPort(int cflag_baud)
@@ -226,6 +305,53 @@ bool PortHandlerLinux::setupPort(int cflag_baud)
   return true;
 }
 
+void PortHandlerLinux::setLowLatency()
+{
+  // ftdi_sio applies a 1 msec latency timer while ASYNC_LOW_LATENCY is set; users may set this flag
+  struct serial_struct ss;
+  if (ioctl(socket_fd_, TIOCGSERIAL, &ss) == 0 && !(ss.flags & ASYNC_LOW_LATENCY))
+  {
+    ss.flags |= ASYNC_LOW_LATENCY;
+    ioctl(socket_fd_, TIOCSSERIAL, &ss);
+  }
+
+  // /dev/serial/by-id/... and other links resolve to /dev/ttyUSB<n>
+  char device_path[PATH_MAX];
+  char sysfs_path[PATH_MAX + 64];
+  if (realpath(port_name_, device_path) == NULL)
+    snprintf(device_path, sizeof(device_path), "%s", port_name_);
+  snprintf(sysfs_path, sizeof(sysfs_path), "/sys/bus/usb-serial/devices/%s/latency_timer", basename(device_path));
+
+  int latency = readLatencyTimer(sysfs_path);
+  if (latency > LOW_LATENCY_TIMER)
+  {
+    FILE *file = fopen(sysfs_path, "w");
+    if (file != NULL)
+    {
+      fprintf(file, "%d", LOW_LATENCY_TIMER);
+      fclose(file);
+      latency = readLatencyTimer(sysfs_path);
+    }
+    if (latency > LOW_LATENCY_TIMER)
+      printf("[PortHandlerLinux::SetLowLatency] %s latency timer is %d msec and could not be lowered (see port_handler_linux.cpp)\n", port_name_, latency);
+  }
+
+  // Not a USB-serial adapter (native UART, CDC-ACM, pty): no latency timer to read, keep the safe default
+  latency_timer_ = (latency >= 0) ? latency : DEFAULT_LATENCY_TIMER;
+}
+
+int PortHandlerLinux::readLatencyTimer(const char *sysfs_path)
+{
+  int latency = -1;
+  FILE *file = fopen(sysfs_path, "r");
+  if (file == NULL)
+    return -1;
+  if (fscanf(file, "%d", &latency) != 1)
+    latency = -1;
+  fclose(file);
+  return latency;
+}
+
 bool PortHandlerLinux::setCustomBaudrate(int speed)
 {
   struct termios2 options;
@@ -62,9 +62,64 @@
 
 using namespace dynamixel;
 
+// CRC-16 (polynomial 0x8005) of one byte
+static const uint16_t crc_table[256] = {0x0000,
+  0x8005, 0x800F, 0x000A, 0x801B, 0x001E, 0x0014, 0x8011,
+  0x8033, 0x0036, 0x003C, 0x8039, 0x0028, 0x802D, 0x8027,
+  0x0022, 0x8063, 0x0066, 0x006C, 0x8069, 0x0078, 0x807D,
+  0x8077, 0x0072, 0x0050, 0x8055, 0x805F, 0x005A, 0x804B,
+  0x004E, 0x0044, 0x8041, 0x80C3, 0x00C6, 0x00CC, 0x80C9,
+  0x00D8, 0x80DD, 0x80D7, 0x00D2, 0x00F0, 0x80F5, 0x80FF,
+  0x00FA, 0x80EB, 0x00EE, 0x00E4, 0x80E1, 0x00A0, 0x80A5,
+  0x80AF, 0x00AA, 0x80BB, 0x00BE, 0x00B4, 0x80B1, 0x8093,
+  0x0096, 0x009C, 0x8099, 0x0088, 0x808D, 0x8087, 0x0082,
+  0x8183, 0x0186, 0x018C, 0x8189, 0x0198, 0x819D, 0x8197,
+  0x0192, 0x01B0, 0x81B5, 0x81BF, 0x01BA, 0x81AB, 0x01AE,
+  0x01A4, 0x81A1, 0x01E0, 0x81E5, 0x81EF, 0x01EA, 0x81FB,
+  0x01FE, 0x01F4, 0x81F1, 0x81D3, 0x01D6, 0x01DC, 0x81D9,
+  0x01C8, 0x81CD, 0x81C7, 0x01C2, 0x0140, 0x8145, 0x814F,
+  0x014A, 0x815B, 0x015E, 0x0154, 0x8151, 0x8173, 0x0176,
+  0x017C, 0x8179, 0x0168, 0x816D, 0x8167, 0x0162, 0x8123,
+  0x0126, 0x012C, 0x8129, 0x0138, 0x813D, 0x8137, 0x0132,
+  0x0110, 0x8115, 0x811F, 0x011A, 0x810B, 0x010E, 0x0104,
+  0x8101, 0x8303, 0x0306, 0x030C, 0x8309, 0x0318, 0x831D,
+  0x8317, 0x0312, 0x0330, 0x8335, 0x833F, 0x033A, 0x832B,
+  0x032E, 0x0324, 0x8321, 0x0360, 0x8365, 0x836F, 0x036A,
+  0x837B, 0x037E, 0x0374, 0x8371, 0x8353, 0x0356, 0x035C,
+  0x8359, 0x0348, 0x834D, 0x8347, 0x0342, 0x03C0, 0x83C5,
+  0x83CF, 0x03CA, 0x83DB, 0x03DE, 0x03D4, 0x83D1, 0x83F3,
+  0x03F6, 0x03FC, 0x83F9, 0x03E8, 0x83ED, 0x83E7, 0x03E2,
+  0x83A3, 0x03A6, 0x03AC, 0x83A9, 0x03B8, 0x83BD, 0x83B7,
+  0x03B2, 0x0390, 0x8395, 0x839F, 0x039A, 0x838B, 0x038E,
+  0x0384, 0x8381, 0x0280, 0x8285, 0x828F, 0x028A, 0x829B,
+  0x029E, 0x0294, 0x8291, 0x82B3, 0x02B6, 0x02BC, 0x82B9,
+  0x02A8, 0x82AD, 0x82A7, 0x02A2, 0x82E3, 0x02E6, 0x02EC,
+  0x82E9, 0x02F8, 0x82FD, 0x82F7, 0x02F2, 0x02D0, 0x82D5,
+  0x82DF, 0x02DA, 0x82CB, 0x02CE, 0x02C4, 0x82C1, 0x8243,
+  0x0246, 0x024C, 0x8249, 0x0258, 0x825D, 0x8257, 0x0252,
+  0x0270, 0x8275, 0x827F, 0x027A, 0x826B, 0x026E, 0x0264,
+  0x8261, 0x0220, 0x8225, 0x822F, 0x022A, 0x823B, 0x023E,
+  0x0234, 0x8231, 0x8213, 0x0216, 0x021C, 0x8219, 0x0208,
+  0x820D, 0x8207, 0x0202 };
+
+// crc_slice_table[k][b]: CRC-16 of byte b followed by (k + 1) zero bytes,
+// derived from crc_table so that updateCRC() can process eight bytes per step (slicing-by-8)
+static uint16_t crc_slice_table[7][256];
+
 Protocol2PacketHandler *Protocol2PacketHandler::unique_instance_ = new Protocol2PacketHandler();
 
-Protocol2PacketHandler::Protocol2PacketHandler() { }
+Protocol2PacketHandler::Protocol2PacketHandler()
+{
+  for (uint16_t b = 0; b < 256; b++)
+  {
+    uint16_t crc = crc_table[b];
+    for (int k = 0; k < 7; k++)
+    {
+      crc = (crc << 8) ^ crc_table[crc >> 8];
+      crc_slice_table[k][b] = crc;
+    }
+  }
+}
 
 const char *Protocol2PacketHandler::getTxRxResult(int result)
 {
@@ -143,44 +198,19 @@ const char *Protocol2PacketHandler::getRxPacketError(uint8_t error)
 unsigned short Protocol2PacketHandler::updateCRC(uint16_t crc_accum, uint8_t *data_blk_ptr, uint16_t data_blk_size)
 {
   uint16_t i;
-  static const uint16_t crc_table[256] = {0x0000,
-  0x8005, 0x800F, 0x000A, 0x801B, 0x001E, 0x0014, 0x8011,
-  0x8033, 0x0036, 0x003C, 0x8039, 0x0028, 0x802D, 0x8027,
-  0x0022, 0x8063, 0x0066, 0x006C, 0x8069, 0x0078, 0x807D,
-  0x8077, 0x0072, 0x0050, 0x8055, 0x805F, 0x005A, 0x804B,
-  0x004E, 0x0044, 0x8041, 0x80C3, 0x00C6, 0x00CC, 0x80C9,
-  0x00D8, 0x80DD, 0x80D7, 0x00D2, 0x00F0, 0x80F5, 0x80FF,
-  0x00FA, 0x80EB, 0x00EE, 0x00E4, 0x80E1, 0x00A0, 0x80A5,
-  0x80AF, 0x00AA, 0x80BB, 0x00BE, 0x00B4, 0x80B1, 0x8093,
-  0x0096, 0x009C, 0x8099, 0x0088, 0x808D, 0x8087, 0x0082,
-  0x8183, 0x0186, 0x018C, 0x8189, 0x0198, 0x819D, 0x8197,
-  0x0192, 0x01B0, 0x81B5, 0x81BF, 0x01BA, 0x81AB, 0x01AE,
-  0x01A4, 0x81A1, 0x01E0, 0x81E5, 0x81EF, 0x01EA, 0x81FB,
-  0x01FE, 0x01F4, 0x81F1, 0x81D3, 0x01D6, 0x01DC, 0x81D9,
-  0x01C8, 0x81CD, 0x81C7, 0x01C2, 0x0140, 0x8145, 0x814F,
-  0x014A, 0x815B, 0x015E, 0x0154, 0x8151, 0x8173, 0x0176,
-  0x017C, 0x8179, 0x0168, 0x816D, 0x8167, 0x0162, 0x8123,
-  0x0126, 0x012C, 0x8129, 0x0138, 0x813D, 0x8137, 0x0132,
-  0x0110, 0x8115, 0x811F, 0x011A, 0x810B, 0x010E, 0x0104,
-  0x8101, 0x8303, 0x0306, 0x030C, 0x8309, 0x0318, 0x831D,
-  0x8317, 0x0312, 0x0330, 0x8335, 0x833F, 0x033A, 0x832B,
-  0x032E, 0x0324, 0x8321, 0x0360, 0x8365, 0x836F, 0x036A,
-  0x837B, 0x037E, 0x0374, 0x8371, 0x8353, 0x0356, 0x035C,
-  0x8359, 0x0348, 0x834D, 0x8347, 0x0342, 0x03C0, 0x83C5,
-  0x83CF, 0x03CA, 0x83DB, 0x03DE, 0x03D4, 0x83D1, 0x83F3,
-  0x03F6, 0x03FC, 0x83F9, 0x03E8, 0x83ED, 0x83E7, 0x03E2,
-  0x83A3, 0x03A6, 0x03AC, 0x83A9, 0x03B8, 0x83BD, 0x83B7,
-  0x03B2, 0x0390, 0x8395, 0x839F, 0x039A, 0x838B, 0x038E,
-  0x0384, 0x8381, 0x0280, 0x8285, 0x828F, 0x028A, 0x829B,
-  0x029E, 0x0294, 0x8291, 0x82B3, 0x02B6, 0x02BC, 0x82B9,
-  0x02A8, 0x82AD, 0x82A7, 0x02A2, 0x82E3, 0x02E6, 0x02EC,
-  0x82E9, 0x02F8, 0x82FD, 0x82F7, 0x02F2, 0x02D0, 0x82D5,
-  0x82DF, 0x02DA, 0x82CB, 0x02CE, 0x02C4, 0x82C1, 0x8243,
-  0x0246, 0x024C, 0x8249, 0x0258, 0x825D, 0x8257, 0x0252,
-  0x0270, 0x8275, 0x827F, 0x027A, 0x826B, 0x026E, 0x0264,
-  0x8261, 0x0220, 0x8225, 0x822F, 0x022A, 0x823B, 0x023E,
-  0x0234, 0x8231, 0x8213, 0x0216, 0x021C, 0x8219, 0x0208,
-  0x820D, 0x8207, 0x0202 };
+
+  // eight bytes per step: the first two are folded into the running CRC,
+  // then each byte is looked up with the number of bytes still following it
+  while (data_blk_size >= 8)
+  {
+    i = crc_accum ^ DXL_MAKEWORD(data_blk_ptr[1], data_blk_ptr[0]);
+    crc_accum = crc_slice_table[6][DXL_HIBYTE(i)] ^ crc_slice_table[5][DXL_LOBYTE(i)] ^
+                crc_slice_table[4][data_blk_ptr[2]] ^ crc_slice_table[3][data_blk_ptr[3]] ^
+                crc_slice_table[2][data_blk_ptr[4]] ^ crc_slice_table[1][data_blk_ptr[5]] ^
+                crc_slice_table[0][data_blk_ptr[6]] ^ crc_table[data_blk_ptr[7]];
+    data_blk_ptr  += 8;
+    data_blk_size -= 8;
+  }
 
   for (uint16_t j = 0; j < data_blk_size; j++)
   {
@@ -191,89 +221,173 @@ unsigned short Protocol2PacketHandler::updateCRC(uint16_t crc_accum, uint8_t *da
   return crc_accum;
 }
 
-void Protocol2PacketHandler::addStuffing(uint8_t *packet)
+// Returns the next FF FF FD of the packet (pointing at its FD) in [from, end), or NULL.
+// memchr jumps over the bytes which cannot end the pattern, so a packet without it costs one scan.
+static uint8_t *findStuffing(uint8_t *from, uint8_t *end)
+{
+  while (from < end)
+  {
+    uint8_t *fd = (uint8_t *)memchr(from, 0xFD, end - from);
+    if (fd == NULL)
+      return NULL;
+    if (fd[-1] == 0xFF && fd[-2] == 0xFF)
+      return fd;
+    from = fd + 1;
+  }
+  return NULL;
+}
+
+uint16_t Protocol2PacketHandler::countStuffing(uint8_t *packet)
 {
   int packet_length_in = DXL_MAKEWORD(packet[PKT_LENGTH_L], packet[PKT_LENGTH_H]);
-  int packet_length_out = packet_length_in;
-  
+  uint16_t stuffing_length = 0;
+
   if (packet_length_in < 8) // INSTRUCTION, ADDR_L, ADDR_H, CRC16_L, CRC16_H + FF FF FD
-    return;
+    return 0;
 
-  uint8_t *packet_ptr;
-  uint16_t packet_length_before_crc = packet_length_in - 2;
-  for (uint16_t i = 3; i < packet_length_before_crc; i++)
+  uint8_t *packet_end = &packet[packet_length_in + 5];  // first byte of CRC16
+  uint8_t *fd = findStuffing(&packet[PKT_INSTRUCTION + 3], packet_end);
+  while (fd != NULL)
   {
-    packet_ptr = &packet[i+PKT_INSTRUCTION-2];
-    if (packet_ptr[0] == 0xFF && packet_ptr[1] == 0xFF && packet_ptr[2] == 0xFD)
-      packet_length_out++;
+    stuffing_length++;
+    fd = findStuffing(fd + 1, packet_end);
   }
-  
-  if (packet_length_in == packet_length_out)  // no stuffing required
-    return;
-  
-  uint16_t out_index  = packet_length_out + 6 - 2;  // last index before crc
-  uint16_t in_index   = packet_length_in + 6 - 2;   // last index before crc
-  while (out_index != in_index)
+
+  return stuffing_length;
+}
+
+void Protocol2PacketHandler::addStuffing(uint8_t *packet, uint8_t *stuffed_packet, uint16_t stuffing_length)
+{
+  int packet_length_in  = DXL_MAKEWORD(packet[PKT_LENGTH_L], packet[PKT_LENGTH_H]);
+  int packet_length_out = packet_length_in + stuffing_length;
+
+  // header with the stuffed length
+  memcpy(stuffed_packet, packet, PKT_LENGTH_L);
+  stuffed_packet[PKT_LENGTH_L] = DXL_LOBYTE(packet_length_out);
+  stuffed_packet[PKT_LENGTH_H] = DXL_HIBYTE(packet_length_out);
+
+  uint16_t out_index = PKT_INSTRUCTION;
+  uint16_t crc       = updateCRC(0, stuffed_packet, out_index);
+
+  // copy the packet one segment at a time, adding the CRC16 of each segment while it is still in cache
+  uint8_t *packet_end = &packet[packet_length_in + 5];  // first byte of CRC16
+  uint8_t *segment    = &packet[PKT_INSTRUCTION];
+  uint8_t *fd         = findStuffing(&packet[PKT_INSTRUCTION + 3], packet_end);
+  while (fd != NULL)
   {
-    if (packet[in_index] == 0xFD && packet[in_index-1] == 0xFF && packet[in_index-2] == 0xFF)
-    {
-      packet[out_index--] = 0xFD; // byte stuffing
-      if (out_index != in_index)
-      {
-        packet[out_index--] = packet[in_index--]; // FD
-        packet[out_index--] = packet[in_index--]; // FF
-        packet[out_index--] = packet[in_index--]; // FF
-      }
-    }
-    else
-    {
-      packet[out_index--] = packet[in_index--];
-    }
+    uint16_t length = fd + 1 - segment;
+    memcpy(&stuffed_packet[out_index], segment, length);
+    stuffed_packet[out_index + length] = 0xFD; // byte stuffing
+    crc = updateCRC(crc, &stuffed_packet[out_index], length + 1);
+    out_index += length + 1;
+
+    segment = fd + 1;
+    fd = findStuffing(segment, packet_end);
   }
 
-  packet[PKT_LENGTH_L] = DXL_LOBYTE(packet_length_out);
-  packet[PKT_LENGTH_H] = DXL_HIBYTE(packet_length_out);
+  uint16_t length = packet_end - segment;
+  memcpy(&stuffed_packet[out_index], segment, length);
+  crc = updateCRC(crc, &stuffed_packet[out_index], length);
+  out_index += length;
 
-  return;
+  stuffed_packet[out_index]     = DXL_LOBYTE(crc);
+  stuffed_packet[out_index + 1] = DXL_HIBYTE(crc);
 }
 
 void Protocol2PacketHandler::removeStuffing(uint8_t *packet)
 {
-  int i = 0, index = 0;
   int packet_length_in = DXL_MAKEWORD(packet[PKT_LENGTH_L], packet[PKT_LENGTH_H]);
   int packet_length_out = packet_length_in;
 
-  index = PKT_INSTRUCTION;
-  for (i = 0; i < packet_length_in - 2; i++)  // except CRC
+  // FF FF FD FD: the second FD is the stuffing byte
+  uint8_t *packet_end = &packet[PKT_INSTRUCTION + packet_length_in - 2];  // first byte of CRC16
+  uint8_t *segment    = &packet[PKT_INSTRUCTION];
+  uint8_t *out        = segment;
+  uint8_t *fd         = findStuffing(segment, packet_end);
+  while (fd != NULL)
   {
-    if (packet[i+PKT_INSTRUCTION] == 0xFD && packet[i+PKT_INSTRUCTION+1] == 0xFD && packet[i+PKT_INSTRUCTION-1] == 0xFF && packet[i+PKT_INSTRUCTION-2] == 0xFF)
-    {   // FF FF FD FD
-      packet_length_out--;
-      i++;
+    if (fd[1] != 0xFD)
+    {
+      fd = findStuffing(fd + 1, packet_end);
+      continue;
     }
-    packet[index++] = packet[i+PKT_INSTRUCTION];
+
+    // keep everything up to the first FD and drop the second one
+    uint16_t length = fd + 1 - segment;
+    if (out != segment)
+      memmove(out, segment, length);
+    out += length;
+    packet_length_out--;
+
+    segment = fd + 2;
+    fd = findStuffing(segment, packet_end);
   }
-  packet[index++] = packet[PKT_INSTRUCTION+packet_length_in-2];
-  packet[index++] = packet[PKT_INSTRUCTION+packet_length_in-1];
+
+  if (packet_length_out == packet_length_in)  // no stuffing in the packet
+    return;
+
+  memmove(out, segment, packet_end + 2 - segment);  // rest of the parameters and CRC16
 
   packet[PKT_LENGTH_L] = DXL_LOBYTE(packet_length_out);
   packet[PKT_LENGTH_H] = DXL_HIBYTE(packet_length_out);
 }
 
+// Packets are built in the buffers of the port when it has them (PortHandlerLinux), and in heap
+// buffers otherwise. A port buffer belongs to the transaction holding the port, so an instruction
+// packet is only built in it once the port is known to be free.
+static int acquireTxPacket(PortHandler *port, uint16_t length, uint8_t **txpacket)
+{
+  if (port->is_using_)
+    return COMM_PORT_BUSY;
+
+  *txpacket = port->getTxPacketBuffer();
+  if (*txpacket == NULL)
+    *txpacket = (uint8_t *)malloc(length);
+  return (*txpacket != NULL) ? COMM_SUCCESS : COMM_TX_FAIL;
+}
+
+static void releaseTxPacket(PortHandler *port, uint8_t *txpacket)
+{
+  if (txpacket != port->getTxPacketBuffer())
+    free(txpacket);
+}
+
+static uint8_t *acquireRxPacket(PortHandler *port)
+{
+  uint8_t *rxpacket = port->getRxPacketBuffer();
+  if (rxpacket == NULL)
+    rxpacket = (uint8_t *)malloc(RXPACKET_MAX_LEN);
+  return rxpacket;
+}
+
+static void releaseRxPacket(PortHandler *port, uint8_t *rxpacket)
+{
+  if (rxpacket != port->getRxPacketBuffer())
+    free(rxpacket);
+}
+
 int Protocol2PacketHandler::txPacket(PortHandler *port, uint8_t *txpacket)
 {
   uint16_t total_packet_length   = 0;
   uint16_t written_packet_length = 0;
+  uint16_t stuffing_length       = 0;
+  uint8_t *stuffed_packet        = NULL;
 
   if (port->is_using_)
     return COMM_PORT_BUSY;
   port->is_using_ = true;
 
+  // make packet header
+  txpacket[PKT_HEADER0]   = 0xFF;
+  txpacket[PKT_HEADER1]   = 0xFF;
+  txpacket[PKT_HEADER2]   = 0xFD;
+  txpacket[PKT_RESERVED]  = 0x00;
+
   // byte stuffing for header
-  addStuffing(txpacket);
+  stuffing_length = countStuffing(txpacket);
 
   // check max packet length
-  total_packet_length = DXL_MAKEWORD(txpacket[PKT_LENGTH_L], txpacket[PKT_LENGTH_H]) + 7;
+  total_packet_length = DXL_MAKEWORD(txpacket[PKT_LENGTH_L], txpacket[PKT_LENGTH_H]) + 7 + stuffing_length;
   // 7: HEADER0 HEADER1 HEADER2 RESERVED ID LENGTH_L LENGTH_H
   if (total_packet_length > TXPACKET_MAX_LEN)
   {
@@ -281,20 +395,33 @@ int Protocol2PacketHandler::txPacket(PortHandler *port, uint8_t *txpacket)
     return COMM_TX_ERROR;
   }
 
-  // make packet header
-  txpacket[PKT_HEADER0]   = 0xFF;
-  txpacket[PKT_HEADER1]   = 0xFF;
-  txpacket[PKT_HEADER2]   = 0xFD;
-  txpacket[PKT_RESERVED]  = 0x00;
-
-  // add CRC16
-  uint16_t crc = updateCRC(0, txpacket, total_packet_length - 2);    // 2: CRC16
-  txpacket[total_packet_length - 2] = DXL_LOBYTE(crc);
-  txpacket[total_packet_length - 1] = DXL_HIBYTE(crc);
+  if (stuffing_length == 0)
+  {
+    // add CRC16
+    uint16_t crc = updateCRC(0, txpacket, total_packet_length - 2);    // 2: CRC16
+    txpacket[total_packet_length - 2] = DXL_LOBYTE(crc);
+    txpacket[total_packet_length - 1] = DXL_HIBYTE(crc);
+  }
+  else
+  {
+    // the stuffed copy is sent and txpacket is left as the caller built it
+    stuffed_packet = port->getTxStuffedPacketBuffer();
+    if (stuffed_packet == NULL)
+      stuffed_packet = (uint8_t *)malloc(total_packet_length);
+    if (stuffed_packet == NULL)
+    {
+      port->is_using_ = false;
+      return COMM_TX_FAIL;
+    }
+    addStuffing(txpacket, stuffed_packet, stuffing_length);
+    txpacket = stuffed_packet;
+  }
 
   // tx packet
   port->clearPort();
   written_packet_length = port->writePort(txpacket, total_packet_length);
+  if (stuffed_packet != port->getTxStuffedPacketBuffer())
+    free(stuffed_packet);
   if (total_packet_length != written_packet_length)
   {
     port->is_using_ = false;
@@ -308,102 +435,107 @@ int Protocol2PacketHandler::rxPacket(PortHandler *port, uint8_t *rxpacket, bool
 {
   int     result         = COMM_TX_FAIL;
 
-  uint16_t rx_length     = 0;
+  // Received bytes are framed in a ring buffer. 'head' is the first byte which may still start
+  // a packet and 'tail' is where the next read lands; both only count up and are wrapped with
+  // RXPACKET_MAX_LEN, so dropping noise in front of a packet never moves a byte.
+  uint8_t  ring[RXPACKET_MAX_LEN];
+  uint32_t head          = 0;
+  uint32_t tail          = 0;
+  bool     header_found  = false;
+  uint16_t packet_length = 0;  // 0 until the header at 'head' has been validated
   uint16_t wait_length   = 11; // minimum length (HEADER0 HEADER1 HEADER2 RESERVED ID LENGTH_L LENGTH_H INST ERROR CRC16_L CRC16_H)
 
   while(true)
   {
-    rx_length += port->readPort(&rxpacket[rx_length], wait_length - rx_length);
-    if (rx_length >= wait_length)
+    uint16_t rx_length = tail - head;
+    if (rx_length < wait_length)
     {
-      uint16_t idx = 0;
+      uint16_t pos  = tail % RXPACKET_MAX_LEN;
+      uint16_t room = RXPACKET_MAX_LEN - pos;
+      int read_length = port->readPort(&ring[pos], (wait_length - rx_length < room) ? wait_length - rx_length : room);
+      if (read_length > 0)
+        tail += read_length;
+    }
 
-      // find packet header
-      for (idx = 0; idx < (rx_length - 3); idx++)
+    // find packet header, resuming from 'head' and jumping to the next 0xFF with memchr
+    while (header_found == false && tail - head >= 4)
+    {
+      uint16_t pos    = head % RXPACKET_MAX_LEN;
+      uint16_t length = RXPACKET_MAX_LEN - pos;
+      if (length > tail - head)
+        length = tail - head;
+
+      uint8_t *ff = (uint8_t *)memchr(&ring[pos], 0xFF, length);
+      if (ff == NULL)
       {
-        if ((rxpacket[idx] == 0xFF) && (rxpacket[idx+1] == 0xFF) && (rxpacket[idx+2] == 0xFD) && (rxpacket[idx+3] != 0xFD))
-          break;
+        head += length;
+        continue;
       }
+      head += ff - &ring[pos];
+      if (tail - head < 4)
+        break;
 
-      if (idx == 0)   // found at the beginning of the packet
+      if ((ring[(head + 1) % RXPACKET_MAX_LEN] == 0xFF) &&
+          (ring[(head + 2) % RXPACKET_MAX_LEN] == 0xFD) &&
+          (ring[(head + 3) % RXPACKET_MAX_LEN] != 0xFD))
+        header_found = true;
+      else
+        head++;
+    }
+
+    if (header_found == true && packet_length == 0 && tail - head > PKT_INSTRUCTION)
+    {
+      uint16_t length = DXL_MAKEWORD(ring[(head + PKT_LENGTH_L) % RXPACKET_MAX_LEN], ring[(head + PKT_LENGTH_H) % RXPACKET_MAX_LEN]) + PKT_LENGTH_H + 1;
+      if (ring[(head + PKT_RESERVED) % RXPACKET_MAX_LEN] != 0x00 ||
+//         ring[(head + PKT_ID) % RXPACKET_MAX_LEN] > 0xFC || // FAST protocol responds with a broadcast ID
+          length < 11 || length > RXPACKET_MAX_LEN ||
+          ring[(head + PKT_INSTRUCTION) % RXPACKET_MAX_LEN] != 0x55)
       {
-        if (rxpacket[PKT_RESERVED] != 0x00 ||
-//           rxpacket[PKT_ID] > 0xFC || // FAST protocol responds with a broadcast ID
-           DXL_MAKEWORD(rxpacket[PKT_LENGTH_L], rxpacket[PKT_LENGTH_H]) > RXPACKET_MAX_LEN ||
-           rxpacket[PKT_INSTRUCTION] != 0x55)
-        {
-          // remove the first byte in the packet
-          for (uint16_t s = 0; s < rx_length - 1; s++)
-            rxpacket[s] = rxpacket[1 + s];
-          //memcpy(&rxpacket[0], &rxpacket[idx], rx_length - idx);
-          rx_length -= 1;
-          continue;
-        }
-
-        // re-calculate the exact length of the rx packet
-        if (wait_length != DXL_MAKEWORD(rxpacket[PKT_LENGTH_L], rxpacket[PKT_LENGTH_H]) + PKT_LENGTH_H + 1)
-        {
-          wait_length = DXL_MAKEWORD(rxpacket[PKT_LENGTH_L], rxpacket[PKT_LENGTH_H]) + PKT_LENGTH_H + 1;
-          continue;
-        }
-
-        if (rx_length < wait_length)
-        {
-          // check timeout
-          if (port->isPacketTimeout() == true)
-          {
-            if (rx_length == 0)
-            {
-              result = COMM_RX_TIMEOUT;
-            }
-            else
-            {
-              result = COMM_RX_CORRUPT;
-            }
-            break;
-          }
-          else
-          {
-            continue;
-          }
-        }
-
-        // verify CRC16
-        uint16_t crc = DXL_MAKEWORD(rxpacket[wait_length-2], rxpacket[wait_length-1]);
-        if (updateCRC(0, rxpacket, wait_length - 2) == crc)
-        {
-          result = COMM_SUCCESS;
-        }
-        else
-        {
-          result = COMM_RX_CORRUPT;
-        }
-        break;
+        // not a status packet: drop the first byte and look for the next header
+        head++;
+        header_found = false;
+        continue;
+      }
+
+      // the exact length of the rx packet
+      packet_length = length;
+      wait_length   = length;
+    }
+
+    if (packet_length != 0 && tail - head >= packet_length)
+    {
+      uint16_t pos   = head % RXPACKET_MAX_LEN;
+      uint16_t first = RXPACKET_MAX_LEN - pos;
+      if (first > packet_length)
+        first = packet_length;
+      memcpy(&rxpacket[0], &ring[pos], first);
+      memcpy(&rxpacket[first], &ring[0], packet_length - first);
+
+      // verify CRC16
+      uint16_t crc = DXL_MAKEWORD(rxpacket[packet_length-2], rxpacket[packet_length-1]);
+      if (updateCRC(0, rxpacket, packet_length - 2) == crc)
+      {
+        result = COMM_SUCCESS;
       }
       else
       {
-        // remove unnecessary packets
-        for (uint16_t s = 0; s < rx_length - idx; s++)
-          rxpacket[s] = rxpacket[idx + s];
-        //memcpy(&rxpacket[0], &rxpacket[idx], rx_length - idx);
-        rx_length -= idx;
+        result = COMM_RX_CORRUPT;
       }
+      break;
     }
-    else
+
+    // check timeout; any byte received, even noise that was dropped, makes it a corrupt packet
+    if (port->isPacketTimeout() == true)
     {
-      // check timeout
-      if (port->isPacketTimeout() == true)
+      if (tail == 0)
       {
-        if (rx_length == 0)
-        {
-          result = COMM_RX_TIMEOUT;
-        }
-        else
-        {
-          result = COMM_RX_CORRUPT;
-        }
-        break;
+        result = COMM_RX_TIMEOUT;
       }
+      else
+      {
+        result = COMM_RX_CORRUPT;
+      }
+      break;
     }
 #if defined(__linux__) || defined(__APPLE__)
     usleep(0);
@@ -699,12 +831,11 @@ int Protocol2PacketHandler::readTx(PortHandler *port, uint8_t id, uint16_t addre
 int Protocol2PacketHandler::readRx(PortHandler *port, uint8_t id, uint16_t length, uint8_t *data, uint8_t *error)
 {
   int result                  = COMM_TX_FAIL;
-  uint8_t *rxpacket           = (uint8_t *)malloc(RXPACKET_MAX_LEN);
-  //(length + 11 + (length/3));  // (length/3): consider stuffing
-  
+  uint8_t *rxpacket           = acquireRxPacket(port);
+
   if (rxpacket == NULL)
     return result;
-  
+
   do {
     result = rxPacket(port, rxpacket);
   } while (result == COMM_SUCCESS && rxpacket[PKT_ID] != id);
@@ -721,8 +852,7 @@ int Protocol2PacketHandler::readRx(PortHandler *port, uint8_t id, uint16_t lengt
     //memcpy(data, &rxpacket[PKT_PARAMETER0+1], length);
   }
 
-  free(rxpacket);
-  //delete[] rxpacket;
+  releaseRxPacket(port, rxpacket);
   return result;
 }
 
@@ -731,17 +861,14 @@ int Protocol2PacketHandler::readTxRx(PortHandler *port, uint8_t id, uint16_t add
   int result                  = COMM_TX_FAIL;
 
   uint8_t txpacket[14]        = {0};
-  uint8_t *rxpacket           = (uint8_t *)malloc(RXPACKET_MAX_LEN);
-  //(length + 11 + (length/3));  // (length/3): consider stuffing
+  uint8_t *rxpacket           = NULL;
 
-  if (rxpacket == NULL)
-    return result;
-  
   if (id >= BROADCAST_ID)
-  {
-    free(rxpacket);
     return COMM_NOT_AVAILABLE;
-  }
+
+  rxpacket = acquireRxPacket(port);
+  if (rxpacket == NULL)
+    return result;
 
   txpacket[PKT_ID]            = id;
   txpacket[PKT_LENGTH_L]      = 7;
@@ -765,8 +892,7 @@ int Protocol2PacketHandler::readTxRx(PortHandler *port, uint8_t id, uint16_t add
     //memcpy(data, &rxpacket[PKT_PARAMETER0+1], length);
   }
 
-  free(rxpacket);
-  //delete[] rxpacket;
+  releaseRxPacket(port, rxpacket);
   return result;
 }
 
@@ -838,9 +964,12 @@ int Protocol2PacketHandler::writeTxOnly(PortHandler *port, uint8_t id, uint16_t
 {
   int result                  = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(length + 12 + (length / 3));
-  
-  if (txpacket == NULL)
+  uint8_t *txpacket           = NULL;
+
+  if (length + 12 > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+  result = acquireTxPacket(port, length + 12, &txpacket);
+  if (result != COMM_SUCCESS)
     return result;
 
   txpacket[PKT_ID]            = id;
@@ -857,8 +986,7 @@ int Protocol2PacketHandler::writeTxOnly(PortHandler *port, uint8_t id, uint16_t
   result = txPacket(port, txpacket);
   port->is_using_ = false;
 
-  free(txpacket);
-  //delete[] txpacket;
+  releaseTxPacket(port, txpacket);
   return result;
 }
 
@@ -866,12 +994,15 @@ int Protocol2PacketHandler::writeTxRx(PortHandler *port, uint8_t id, uint16_t ad
 {
   int result                  = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(length + 12 + (length / 3));
+  uint8_t *txpacket           = NULL;
   uint8_t rxpacket[11]        = {0};
 
-  if (txpacket == NULL)
+  if (length + 12 > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+  result = acquireTxPacket(port, length + 12, &txpacket);
+  if (result != COMM_SUCCESS)
     return result;
-  
+
   txpacket[PKT_ID]            = id;
   txpacket[PKT_LENGTH_L]      = DXL_LOBYTE(length+5);
   txpacket[PKT_LENGTH_H]      = DXL_HIBYTE(length+5);
@@ -885,8 +1016,7 @@ int Protocol2PacketHandler::writeTxRx(PortHandler *port, uint8_t id, uint16_t ad
 
   result = txRxPacket(port, txpacket, rxpacket, error);
 
-  free(txpacket);
-  //delete[] txpacket;
+  releaseTxPacket(port, txpacket);
   return result;
 }
 
@@ -927,11 +1057,14 @@ int Protocol2PacketHandler::regWriteTxOnly(PortHandler *port, uint8_t id, uint16
 {
   int result                  = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(length + 12 + (length / 3));
+  uint8_t *txpacket           = NULL;
 
-  if (txpacket == NULL)
+  if (length + 12 > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+  result = acquireTxPacket(port, length + 12, &txpacket);
+  if (result != COMM_SUCCESS)
     return result;
-  
+
   txpacket[PKT_ID]            = id;
   txpacket[PKT_LENGTH_L]      = DXL_LOBYTE(length+5);
   txpacket[PKT_LENGTH_H]      = DXL_HIBYTE(length+5);
@@ -946,8 +1079,7 @@ int Protocol2PacketHandler::regWriteTxOnly(PortHandler *port, uint8_t id, uint16
   result = txPacket(port, txpacket);
   port->is_using_ = false;
 
-  free(txpacket);
-  //delete[] txpacket;
+  releaseTxPacket(port, txpacket);
   return result;
 }
 
@@ -955,12 +1087,15 @@ int Protocol2PacketHandler::regWriteTxRx(PortHandler *port, uint8_t id, uint16_t
 {
   int result                  = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(length + 12 + (length / 3));
+  uint8_t *txpacket           = NULL;
   uint8_t rxpacket[11]        = {0};
 
-  if (txpacket == NULL)
+  if (length + 12 > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+  result = acquireTxPacket(port, length + 12, &txpacket);
+  if (result != COMM_SUCCESS)
     return result;
-  
+
   txpacket[PKT_ID]            = id;
   txpacket[PKT_LENGTH_L]      = DXL_LOBYTE(length+5);
   txpacket[PKT_LENGTH_H]      = DXL_HIBYTE(length+5);
@@ -974,8 +1109,7 @@ int Protocol2PacketHandler::regWriteTxRx(PortHandler *port, uint8_t id, uint16_t
 
   result = txRxPacket(port, txpacket, rxpacket, error);
 
-  free(txpacket);
-  //delete[] txpacket;
+  releaseTxPacket(port, txpacket);
   return result;
 }
 
@@ -983,12 +1117,15 @@ int Protocol2PacketHandler::syncReadTx(PortHandler *port, uint16_t start_address
 {
   int result                  = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(param_length + 14 + (param_length / 3));
+  uint8_t *txpacket           = NULL;
   // 14: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
 
-  if (txpacket == NULL)
+  if (param_length + 14 > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+  result = acquireTxPacket(port, param_length + 14, &txpacket);
+  if (result != COMM_SUCCESS)
     return result;
-  
+
   txpacket[PKT_ID]            = BROADCAST_ID;
   txpacket[PKT_LENGTH_L]      = DXL_LOBYTE(param_length + 7); // 7: INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
   txpacket[PKT_LENGTH_H]      = DXL_HIBYTE(param_length + 7); // 7: INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
@@ -1006,7 +1143,7 @@ int Protocol2PacketHandler::syncReadTx(PortHandler *port, uint16_t start_address
   if (result == COMM_SUCCESS)
     port->setPacketTimeout((uint16_t)((11 + data_length) * param_length));
 
-  free(txpacket);
+  releaseTxPacket(port, txpacket);
   return result;
 }
 
@@ -1014,12 +1151,15 @@ int Protocol2PacketHandler::syncWriteTxOnly(PortHandler *port, uint16_t start_ad
 {
   int result                  = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(param_length + 14 + (param_length / 3));
+  uint8_t *txpacket           = NULL;
   // 14: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
 
-  if (txpacket == NULL)
+  if (param_length + 14 > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+  result = acquireTxPacket(port, param_length + 14, &txpacket);
+  if (result != COMM_SUCCESS)
     return result;
-  
+
   txpacket[PKT_ID]            = BROADCAST_ID;
   txpacket[PKT_LENGTH_L]      = DXL_LOBYTE(param_length + 7); // 7: INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
   txpacket[PKT_LENGTH_H]      = DXL_HIBYTE(param_length + 7); // 7: INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
@@ -1035,8 +1175,7 @@ int Protocol2PacketHandler::syncWriteTxOnly(PortHandler *port, uint16_t start_ad
 
   result = txRxPacket(port, txpacket, 0, 0);
 
-  free(txpacket);
-  //delete[] txpacket;
+  releaseTxPacket(port, txpacket);
   return result;
 }
 
@@ -1044,12 +1183,15 @@ int Protocol2PacketHandler::bulkReadTx(PortHandler *port, uint8_t *param, uint16
 {
   int result                  = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(param_length + 10 + (param_length / 3));
+  uint8_t *txpacket           = NULL;
   // 10: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST CRC16_L CRC16_H
 
-  if (txpacket == NULL)
+  if (param_length + 10 > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+  result = acquireTxPacket(port, param_length + 10, &txpacket);
+  if (result != COMM_SUCCESS)
     return result;
-  
+
   txpacket[PKT_ID]            = BROADCAST_ID;
   txpacket[PKT_LENGTH_L]      = DXL_LOBYTE(param_length + 3); // 3: INST CRC16_L CRC16_H
   txpacket[PKT_LENGTH_H]      = DXL_HIBYTE(param_length + 3); // 3: INST CRC16_L CRC16_H
@@ -1068,8 +1210,7 @@ int Protocol2PacketHandler::bulkReadTx(PortHandler *port, uint8_t *param, uint16
     port->setPacketTimeout((uint16_t)wait_length);
   }
 
-  free(txpacket);
-  //delete[] txpacket;
+  releaseTxPacket(port, txpacket);
   return result;
 }
 
@@ -1077,12 +1218,15 @@ int Protocol2PacketHandler::bulkWriteTxOnly(PortHandler *port, uint8_t *param, u
 {
   int result                  = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(param_length + 10 + (param_length / 3));
+  uint8_t *txpacket           = NULL;
   // 10: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST CRC16_L CRC16_H
 
-  if (txpacket == NULL)
+  if (param_length + 10 > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+  result = acquireTxPacket(port, param_length + 10, &txpacket);
+  if (result != COMM_SUCCESS)
     return result;
-  
+
   txpacket[PKT_ID]            = BROADCAST_ID;
   txpacket[PKT_LENGTH_L]      = DXL_LOBYTE(param_length + 3); // 3: INST CRC16_L CRC16_H
   txpacket[PKT_LENGTH_H]      = DXL_HIBYTE(param_length + 3); // 3: INST CRC16_L CRC16_H
@@ -1094,8 +1238,7 @@ int Protocol2PacketHandler::bulkWriteTxOnly(PortHandler *port, uint8_t *param, u
 
   result = txRxPacket(port, txpacket, 0, 0);
 
-  free(txpacket);
-  //delete[] txpacket;
+  releaseTxPacket(port, txpacket);
   return result;
 }
 
@@ -1103,10 +1246,13 @@ int Protocol2PacketHandler::fastSyncReadTx(PortHandler *port, uint16_t start_add
 {
     int result = COMM_TX_FAIL;
 
-    uint8_t *txpacket = (uint8_t *)malloc(param_length + 14 + (param_length / 3));
+    uint8_t *txpacket = NULL;
     // 14: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
 
-    if (NULL == txpacket)
+    if (TXPACKET_MAX_LEN < param_length + 14)
+        return COMM_TX_ERROR;
+    result = acquireTxPacket(port, param_length + 14, &txpacket);
+    if (result != COMM_SUCCESS)
         return result;
 
     txpacket[PKT_ID]             = BROADCAST_ID;
@@ -1126,7 +1272,7 @@ int Protocol2PacketHandler::fastSyncReadTx(PortHandler *port, uint16_t start_add
     if (COMM_SUCCESS == result)
         port->setPacketTimeout((uint16_t)((11 + data_length) * param_length));
 
-    free(txpacket);
+    releaseTxPacket(port, txpacket);
     return result;
 }
 
@@ -1134,10 +1280,13 @@ int Protocol2PacketHandler::fastBulkReadTx(PortHandler *port, uint8_t *param, ui
 {
     int result = COMM_TX_FAIL;
 
-    uint8_t *txpacket = (uint8_t *)malloc(param_length + 10 + (param_length / 3));
+    uint8_t *txpacket = NULL;
     // 10: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST CRC16_L CRC16_H
 
-    if (NULL == txpacket)
+    if (TXPACKET_MAX_LEN < param_length + 10)
+        return COMM_TX_ERROR;
+    result = acquireTxPacket(port, param_length + 10, &txpacket);
+    if (result != COMM_SUCCESS)
         return result;
 
     txpacket[PKT_ID]          = BROADCAST_ID;
@@ -1157,7 +1306,6 @@ int Protocol2PacketHandler::fastBulkReadTx(PortHandler *port, uint8_t *param, ui
         port->setPacketTimeout((uint16_t)wait_length);
     }
 
-    free(txpacket);
-    //delete[] txpacket;
+    releaseTxPacket(port, txpacket);
     return result;
 }
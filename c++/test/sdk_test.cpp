@@ -0,0 +1,515 @@
+//
+// *********     SDK Regression Test      *********
+//
+//
+// Checks the Protocol 2.0 packet handler and the group handlers without any Dynamixel:
+//   testRxSilence     rxPacket with nothing received times out (COMM_RX_TIMEOUT)
+//   testRxNoise       rxPacket with only noise received reports COMM_RX_CORRUPT
+//   testRxChunked     a status packet arriving a byte at a time is framed
+//   testRxWrapped     a status packet behind noise and a false header, crossing the end of the ring buffer
+//   testTxStuffing    txPacket sends what the original in-place byte stuffing sent (random packets)
+//   testRxStuffing    rxPacket gets back the parameters the original byte stuffing was applied to
+//                     (random packets; the original removeStuffing compares against bytes it has
+//                     already shifted, so it is no reference)
+//   testPortBusy      a transaction started while the port is in use is rejected
+//   testSyncWrite     GroupSyncWrite after changeParam and remove/re-add of a servo
+//   testSyncRead      GroupSyncRead::getData after remove/re-add of a servo
+//   testBulkRead      GroupBulkRead::getData after re-adding a servo with another address
+//
+// The packet handler tests talk to a bare pseudo-terminal; the group tests run against
+// a dxl_simulator chain of four servos. Exits with 1 when any check fails.
+//
+// Usage: sdk_test
+//
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "dynamixel_sdk.h"                                  // Uses Dynamixel SDK library
+#include "protocol2_packet_handler.h"
+#include "dxl_simulator.h"
+
+// Control table address
+#define ADDR_PRO_ID                     7
+#define ADDR_PRO_LED                    65
+#define ADDR_PRO_GOAL_POSITION          116
+
+// Data Byte Length
+#define LEN_PRO_GOAL_POSITION           4
+
+// Protocol version
+#define PROTOCOL_VERSION                2.0
+
+#define STUFFING_ITERATIONS             3000
+
+// Protocol 2.0 packet layout
+#define PKT_ID                          4
+#define PKT_LENGTH_L                    5
+#define PKT_LENGTH_H                    6
+#define PKT_INSTRUCTION                 7
+#define PKT_PARAMETER0                  8
+
+static int failures = 0;
+
+#define CHECK(condition)                                                        \
+  do                                                                            \
+  {                                                                             \
+    if (!(condition))                                                           \
+    {                                                                           \
+      printf("  %s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);   \
+      failures++;                                                               \
+    }                                                                           \
+  } while (0)
+
+// The in-place byte stuffing of the SDK before Protocol2PacketHandler::addStuffing took a
+// second buffer, kept as the reference for what goes on the wire
+static void originalAddStuffing(uint8_t *packet)
+{
+  int packet_length_in = DXL_MAKEWORD(packet[PKT_LENGTH_L], packet[PKT_LENGTH_H]);
+  int packet_length_out = packet_length_in;
+
+  if (packet_length_in < 8) // INSTRUCTION, ADDR_L, ADDR_H, CRC16_L, CRC16_H + FF FF FD
+    return;
+
+  uint8_t *packet_ptr;
+  uint16_t packet_length_before_crc = packet_length_in - 2;
+  for (uint16_t i = 3; i < packet_length_before_crc; i++)
+  {
+    packet_ptr = &packet[i+PKT_INSTRUCTION-2];
+    if (packet_ptr[0] == 0xFF && packet_ptr[1] == 0xFF && packet_ptr[2] == 0xFD)
+      packet_length_out++;
+  }
+
+  if (packet_length_in == packet_length_out)  // no stuffing required
+    return;
+
+  uint16_t out_index  = packet_length_out + 6 - 2;  // last index before crc
+  uint16_t in_index   = packet_length_in + 6 - 2;   // last index before crc
+  while (out_index != in_index)
+  {
+    if (packet[in_index] == 0xFD && packet[in_index-1] == 0xFF && packet[in_index-2] == 0xFF)
+    {
+      packet[out_index--] = 0xFD; // byte stuffing
+      if (out_index != in_index)
+      {
+        packet[out_index--] = packet[in_index--]; // FD
+        packet[out_index--] = packet[in_index--]; // FF
+        packet[out_index--] = packet[in_index--]; // FF
+      }
+    }
+    else
+    {
+      packet[out_index--] = packet[in_index--];
+    }
+  }
+
+  packet[PKT_LENGTH_L] = DXL_LOBYTE(packet_length_out);
+  packet[PKT_LENGTH_H] = DXL_HIBYTE(packet_length_out);
+}
+
+// Total length of a packet from its LENGTH field
+static uint16_t packetLength(const uint8_t *packet)
+{
+  return DXL_MAKEWORD(packet[PKT_LENGTH_L], packet[PKT_LENGTH_H]) + 7;  // 7: HEADER0 HEADER1 HEADER2 RESERVED ID LENGTH_L LENGTH_H
+}
+
+// Fills in the header and the CRC16 of a packet whose ID, LENGTH and body are set
+static void finishPacket(uint8_t *packet)
+{
+  uint16_t length = packetLength(packet);
+  packet[0] = 0xFF;
+  packet[1] = 0xFF;
+  packet[2] = 0xFD;
+  packet[3] = 0x00;
+  uint16_t crc = dynamixel::Protocol2PacketHandler::getInstance()->updateCRC(0, packet, length - 2);
+  packet[length - 2] = DXL_LOBYTE(crc);
+  packet[length - 1] = DXL_HIBYTE(crc);
+}
+
+// Parameters with many FF FF FD runs, so that stuffing is exercised at every position
+static void randomParameters(uint8_t *params, uint16_t length)
+{
+  for (uint16_t i = 0; i < length; i++)
+  {
+    int r = rand() % 8;
+    params[i] = (r < 3) ? 0xFF : (r < 5) ? 0xFD : (uint8_t)rand();
+  }
+}
+
+static bool writeAll(int fd, const uint8_t *data, int length)
+{
+  while (length > 0)
+  {
+    int written = write(fd, data, length);
+    if (written <= 0)
+      return false;
+    data += written;
+    length -= written;
+  }
+  return true;
+}
+
+// Reads exactly `length` bytes, waiting up to 100 msec for each
+static bool readAll(int fd, uint8_t *data, int length)
+{
+  while (length > 0)
+  {
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    if (poll(&pfd, 1, 100) <= 0)
+      return false;
+    int received = read(fd, data, length);
+    if (received <= 0)
+      return false;
+    data += received;
+    length -= received;
+  }
+  return true;
+}
+
+// Nothing more arrives within 20 msec
+static bool nothingMore(int fd)
+{
+  struct pollfd pfd = { fd, POLLIN, 0 };
+  return poll(&pfd, 1, 20) == 0;
+}
+
+struct SlowWriter
+{
+  int            fd;
+  const uint8_t *data;
+  int            length;
+};
+
+// Writes one byte per msec, as a slow servo or a USB adapter splitting the packet would
+static void *writeSlowly(void *arg)
+{
+  SlowWriter *writer = (SlowWriter *)arg;
+  for (int i = 0; i < writer->length; i++)
+  {
+    usleep(1000);
+    writeAll(writer->fd, &writer->data[i], 1);
+  }
+  return NULL;
+}
+
+static void testRxSilence(dynamixel::PortHandler *portHandler, dynamixel::PacketHandler *packetHandler, int master_fd)
+{
+  uint8_t rxpacket[1024];
+  portHandler->clearPort();
+  portHandler->setPacketTimeout((uint16_t)11);
+  CHECK(packetHandler->rxPacket(portHandler, rxpacket) == COMM_RX_TIMEOUT);
+}
+
+static void testRxNoise(dynamixel::PortHandler *portHandler, dynamixel::PacketHandler *packetHandler, int master_fd)
+{
+  uint8_t rxpacket[1024];
+  uint8_t noise[20];
+  for (int i = 0; i < 20; i++)
+    noise[i] = 0x11 * (i % 15);                             // Never 0xFF, so never a header
+
+  portHandler->clearPort();
+  CHECK(writeAll(master_fd, noise, sizeof(noise)));
+  portHandler->setPacketTimeout((uint16_t)11);
+  CHECK(packetHandler->rxPacket(portHandler, rxpacket) == COMM_RX_CORRUPT);
+}
+
+static void testRxChunked(dynamixel::PortHandler *portHandler, dynamixel::PacketHandler *packetHandler, int master_fd)
+{
+  uint8_t status[64] = { 0 };
+  status[PKT_ID] = 3;
+  status[PKT_LENGTH_L] = 8;                                 // INST ERROR 4 data CRC16
+  status[PKT_INSTRUCTION] = INST_STATUS;
+  status[PKT_PARAMETER0 + 1] = 0x12;
+  status[PKT_PARAMETER0 + 4] = 0x34;
+  finishPacket(status);
+  uint16_t length = packetLength(status);
+
+  portHandler->clearPort();
+  SlowWriter writer = { master_fd, status, length };
+  pthread_t thread;
+  CHECK(pthread_create(&thread, NULL, writeSlowly, &writer) == 0);
+
+  uint8_t rxpacket[1024];
+  portHandler->setPacketTimeout(200.0);
+  CHECK(packetHandler->rxPacket(portHandler, rxpacket) == COMM_SUCCESS);
+  CHECK(memcmp(rxpacket, status, length) == 0);
+  pthread_join(thread, NULL);
+}
+
+static void testRxWrapped(dynamixel::PortHandler *portHandler, dynamixel::PacketHandler *packetHandler, int master_fd)
+{
+  std::vector<uint8_t> bytes;
+  for (int i = 0; i < 1000; i++)
+    bytes.push_back((uint8_t)((i * 7) % 0xFF));             // Noise without 0xFF
+
+  // A header whose instruction is not a status packet must be skipped, not trusted
+  uint8_t false_header[] = { 0xFF, 0xFF, 0xFD, 0x00, 0x01, 0x07, 0x00, 0x02 };
+  bytes.insert(bytes.end(), false_header, false_header + sizeof(false_header));
+
+  uint8_t status[64] = { 0 };
+  status[PKT_ID] = 5;
+  status[PKT_LENGTH_L] = 24;                                // INST ERROR 20 data CRC16
+  status[PKT_INSTRUCTION] = INST_STATUS;
+  for (int i = 0; i < 20; i++)
+    status[PKT_PARAMETER0 + 1 + i] = (uint8_t)(0xA0 + i);
+  finishPacket(status);
+  uint16_t length = packetLength(status);
+  bytes.insert(bytes.end(), status, status + length);       // Crosses the end of the 1024 byte ring
+
+  portHandler->clearPort();
+  CHECK(writeAll(master_fd, &bytes[0], bytes.size()));
+
+  uint8_t rxpacket[1024];
+  portHandler->setPacketTimeout(200.0);
+  CHECK(packetHandler->rxPacket(portHandler, rxpacket) == COMM_SUCCESS);
+  CHECK(memcmp(rxpacket, status, length) == 0);
+}
+
+static void testTxStuffing(dynamixel::PortHandler *portHandler, dynamixel::PacketHandler *packetHandler, int master_fd)
+{
+  srand(1);
+  int mismatches = 0;
+  for (int n = 0; n < STUFFING_ITERATIONS; n++)
+  {
+    uint8_t txpacket[1024] = { 0 };
+    uint8_t expected[1024] = { 0 };
+    uint8_t sent[1024];
+    uint16_t param_length = rand() % 240;
+
+    txpacket[PKT_ID] = 1 + rand() % 12;
+    txpacket[PKT_LENGTH_L] = DXL_LOBYTE(param_length + 3);  // 3: INST CRC16_L CRC16_H
+    txpacket[PKT_LENGTH_H] = DXL_HIBYTE(param_length + 3);
+    txpacket[PKT_INSTRUCTION] = INST_WRITE;
+    randomParameters(&txpacket[PKT_PARAMETER0], param_length);
+
+    memcpy(expected, txpacket, param_length + 8);
+    originalAddStuffing(expected);
+    finishPacket(expected);
+    uint16_t length = packetLength(expected);
+
+    int result = packetHandler->txPacket(portHandler, txpacket);
+    portHandler->is_using_ = false;
+    if (result != COMM_SUCCESS || !readAll(master_fd, sent, length) || memcmp(sent, expected, length) != 0)
+      mismatches++;
+  }
+  CHECK(mismatches == 0);
+  CHECK(nothingMore(master_fd));
+}
+
+static void testRxStuffing(dynamixel::PortHandler *portHandler, dynamixel::PacketHandler *packetHandler, int master_fd)
+{
+  srand(2);
+  int mismatches = 0;
+  for (int n = 0; n < STUFFING_ITERATIONS; n++)
+  {
+    uint8_t status[1024] = { 0 };
+    uint8_t expected[1024];
+    uint8_t rxpacket[1024];
+    uint16_t param_length = rand() % 240;
+
+    status[PKT_ID] = 1 + rand() % 12;
+    status[PKT_LENGTH_L] = DXL_LOBYTE(param_length + 4);   // 4: INST ERROR CRC16_L CRC16_H
+    status[PKT_LENGTH_H] = DXL_HIBYTE(param_length + 4);
+    status[PKT_INSTRUCTION] = INST_STATUS;
+    randomParameters(&status[PKT_PARAMETER0 + 1], param_length);
+    memcpy(expected, status, param_length + 9);             // Up to the CRC16, which follows the stuffed packet
+
+    originalAddStuffing(status);
+    finishPacket(status);
+    uint16_t length = packetLength(status);
+
+    portHandler->clearPort();
+    writeAll(master_fd, status, length);
+    portHandler->setPacketTimeout(200.0);
+    int result = packetHandler->rxPacket(portHandler, rxpacket);
+    if (result != COMM_SUCCESS || memcmp(&rxpacket[PKT_ID], &expected[PKT_ID], param_length + 9 - PKT_ID) != 0)
+      mismatches++;
+  }
+  CHECK(mismatches == 0);
+}
+
+static void testPortBusy(dynamixel::PortHandler *portHandler, dynamixel::PacketHandler *packetHandler)
+{
+  dynamixel::GroupSyncWrite groupSyncWrite(portHandler, packetHandler, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION);
+  uint8_t goal[4] = { 0x00, 0x08, 0x00, 0x00 };
+  CHECK(groupSyncWrite.addParam(1, goal));
+
+  portHandler->is_using_ = true;                            // Another transaction holds the port
+  CHECK(packetHandler->write1ByteTxOnly(portHandler, 1, ADDR_PRO_LED, 1) == COMM_PORT_BUSY);
+  CHECK(groupSyncWrite.txPacket() == COMM_PORT_BUSY);
+  portHandler->is_using_ = false;
+}
+
+static uint32_t readGoal(dynamixel::PortHandler *portHandler, dynamixel::PacketHandler *packetHandler, uint8_t id)
+{
+  uint32_t position = 0;
+  uint8_t dxl_error = 0;
+  if (packetHandler->read4ByteTxRx(portHandler, id, ADDR_PRO_GOAL_POSITION, &position, &dxl_error) != COMM_SUCCESS)
+    return 0xFFFFFFFF;
+  return position;
+}
+
+static void makeGoal(uint32_t position, uint8_t *goal)
+{
+  goal[0] = DXL_LOBYTE(DXL_LOWORD(position));
+  goal[1] = DXL_HIBYTE(DXL_LOWORD(position));
+  goal[2] = DXL_LOBYTE(DXL_HIWORD(position));
+  goal[3] = DXL_HIBYTE(DXL_HIWORD(position));
+}
+
+// Leaves the goals of servos 1-4 at 1001, 3000, 3333 and 1004 for the read tests
+static void testSyncWrite(dynamixel::PortHandler *portHandler, dynamixel::PacketHandler *packetHandler)
+{
+  dynamixel::GroupSyncWrite groupSyncWrite(portHandler, packetHandler, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION);
+  uint8_t goal[4];
+  for (uint8_t id = 1; id <= 4; id++)
+  {
+    makeGoal(1000 + id, goal);
+    CHECK(groupSyncWrite.addParam(id, goal));
+  }
+  CHECK(!groupSyncWrite.addParam(2, goal));                 // Already listed
+  makeGoal(3000, goal);
+  CHECK(groupSyncWrite.changeParam(2, goal));
+  groupSyncWrite.removeParam(3);
+  makeGoal(3333, goal);
+  CHECK(!groupSyncWrite.changeParam(3, goal));              // No longer listed
+  CHECK(groupSyncWrite.addParam(3, goal));
+
+  CHECK(groupSyncWrite.txPacket() == COMM_SUCCESS);
+  CHECK(readGoal(portHandler, packetHandler, 1) == 1001);
+  CHECK(readGoal(portHandler, packetHandler, 2) == 3000);
+  CHECK(readGoal(portHandler, packetHandler, 3) == 3333);
+  CHECK(readGoal(portHandler, packetHandler, 4) == 1004);
+
+  // The same goals again: changeParam rewrites the listed data in place
+  makeGoal(2000, goal);
+  CHECK(groupSyncWrite.changeParam(4, goal));
+  CHECK(groupSyncWrite.txPacket() == COMM_SUCCESS);
+  CHECK(readGoal(portHandler, packetHandler, 4) == 2000);
+  CHECK(readGoal(portHandler, packetHandler, 1) == 1001);
+  makeGoal(1004, goal);
+  CHECK(groupSyncWrite.changeParam(4, goal));
+  CHECK(groupSyncWrite.txPacket() == COMM_SUCCESS);
+  CHECK(readGoal(portHandler, packetHandler, 4) == 1004);
+}
+
+static void testSyncRead(dynamixel::PortHandler *portHandler, dynamixel::PacketHandler *packetHandler)
+{
+  dynamixel::GroupSyncRead groupSyncRead(portHandler, packetHandler, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION);
+  for (uint8_t id = 1; id <= 4; id++)
+    CHECK(groupSyncRead.addParam(id));
+  groupSyncRead.removeParam(2);
+
+  CHECK(groupSyncRead.txRxPacket() == COMM_SUCCESS);
+  CHECK(!groupSyncRead.isAvailable(2, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION));
+  CHECK(groupSyncRead.getData(1, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION) == 1001);
+  CHECK(groupSyncRead.getData(3, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION) == 3333);
+  CHECK(groupSyncRead.getData(4, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION) == 1004);
+
+  CHECK(groupSyncRead.addParam(2));                         // Re-added, now last in the list
+  CHECK(groupSyncRead.txRxPacket() == COMM_SUCCESS);
+  CHECK(groupSyncRead.isAvailable(2, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION));
+  CHECK(groupSyncRead.getData(1, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION) == 1001);
+  CHECK(groupSyncRead.getData(2, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION) == 3000);
+  CHECK(groupSyncRead.getData(3, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION) == 3333);
+  CHECK(groupSyncRead.getData(4, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION) == 1004);
+}
+
+static void testBulkRead(dynamixel::PortHandler *portHandler, dynamixel::PacketHandler *packetHandler)
+{
+  dynamixel::GroupBulkRead groupBulkRead(portHandler, packetHandler);
+  CHECK(groupBulkRead.addParam(1, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION));
+  CHECK(groupBulkRead.addParam(2, ADDR_PRO_ID, 1));
+  CHECK(groupBulkRead.addParam(3, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION));
+  CHECK(groupBulkRead.addParam(4, ADDR_PRO_ID, 1));
+
+  CHECK(groupBulkRead.txRxPacket() == COMM_SUCCESS);
+  CHECK(groupBulkRead.getData(2, ADDR_PRO_ID, 1) == 2);
+  CHECK(groupBulkRead.getData(4, ADDR_PRO_ID, 1) == 4);
+
+  groupBulkRead.removeParam(2);
+  CHECK(groupBulkRead.addParam(2, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION));  // Another address and length
+  CHECK(groupBulkRead.txRxPacket() == COMM_SUCCESS);
+  CHECK(!groupBulkRead.isAvailable(2, ADDR_PRO_ID, 1));
+  CHECK(groupBulkRead.getData(1, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION) == 1001);
+  CHECK(groupBulkRead.getData(2, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION) == 3000);
+  CHECK(groupBulkRead.getData(3, ADDR_PRO_GOAL_POSITION, LEN_PRO_GOAL_POSITION) == 3333);
+  CHECK(groupBulkRead.getData(4, ADDR_PRO_ID, 1) == 4);
+}
+
+// Runs one test and prints whether its checks passed
+#define RUN(test, ...)                                                          \
+  do                                                                            \
+  {                                                                             \
+    int failures_before = failures;                                             \
+    test(__VA_ARGS__);                                                          \
+    printf("%-14s %s\n", #test, failures == failures_before ? "ok" : "FAILED"); \
+  } while (0)
+
+int main()
+{
+  dynamixel::PacketHandler *packetHandler = dynamixel::PacketHandler::getPacketHandler(PROTOCOL_VERSION);
+
+  // Packet handler against a bare pseudo-terminal; the test writes and reads its other side
+  int master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master_fd < 0 || grantpt(master_fd) != 0 || unlockpt(master_fd) != 0)
+  {
+    printf("Failed to create a pseudo-terminal\n");
+    return 1;
+  }
+  dynamixel::PortHandler *portHandler = dynamixel::PortHandler::getPortHandler(ptsname(master_fd));
+  if (!portHandler->openPort())
+  {
+    printf("Failed to open %s\n", ptsname(master_fd));
+    return 1;
+  }
+
+  RUN(testRxSilence, portHandler, packetHandler, master_fd);
+  RUN(testRxNoise, portHandler, packetHandler, master_fd);
+  RUN(testRxChunked, portHandler, packetHandler, master_fd);
+  RUN(testRxWrapped, portHandler, packetHandler, master_fd);
+  RUN(testTxStuffing, portHandler, packetHandler, master_fd);
+  RUN(testRxStuffing, portHandler, packetHandler, master_fd);
+  RUN(testPortBusy, portHandler, packetHandler);
+
+  portHandler->closePort();
+  delete portHandler;
+  close(master_fd);
+
+  // Group handlers against four simulated servos
+  SimOptions options;
+  options.first_id = 1;
+  options.last_id = 4;
+  options.return_delay = 0;
+  options.model_wire_time = false;
+
+  DxlSimulator simulator(options);
+  if (!simulator.open(NULL) || !simulator.start())
+  {
+    printf("Failed to start the simulator\n");
+    return 1;
+  }
+  portHandler = dynamixel::PortHandler::getPortHandler(simulator.getPortName());
+  if (!portHandler->openPort())
+  {
+    printf("Failed to open %s\n", simulator.getPortName());
+    return 1;
+  }
+
+  RUN(testSyncWrite, portHandler, packetHandler);
+  RUN(testSyncRead, portHandler, packetHandler);
+  RUN(testBulkRead, portHandler, packetHandler);
+
+  portHandler->closePort();
+  delete portHandler;
+  simulator.stop();
+
+  printf("%s\n", failures == 0 ? "All tests passed" : "Some tests FAILED");
+  return failures == 0 ? 0 : 1;
+}
@@ -5,7 +5,7 @@ from rclpy.action import ActionServer, CancelResponse, GoalResponse
 from rclpy.node import Node
 from quad_interfaces.action import Move
 from quad_interfaces.msg import RobotState
-from quad_interfaces.msg import MotorPositions
+from quad_interfaces.msg import MotorState
 from std_msgs.msg import String
 
 import time
@@ -40,9 +40,9 @@ class MoveActionServer(Node):
         self.current_motor_pos = [None]*12
 
         # Subscribers
-        self.motor_positions_subscriber = self.create_subscription(
-            MotorPositions,
-            '/motor_positions',
+        self.motor_state_subscriber = self.create_subscription(
+            MotorState,
+            '/motor_state',
             self.get_motor_pos,
             10
         )
@@ -62,13 +62,8 @@ class MoveActionServer(Node):
         self.get_logger().info("MoveActionServer is ready.")
 
     def get_motor_pos(self, msg):
-        """Updates the current motor positions from the MotorPositions message."""
-        self.current_motor_pos = [
-            msg.motor1_position, msg.motor2_position, msg.motor3_position,
-            msg.motor4_position, msg.motor5_position, msg.motor6_position,
-            msg.motor7_position, msg.motor8_position, msg.motor9_position,
-            msg.motor10_position, msg.motor11_position, msg.motor12_position
-        ]
+        """Updates the current motor positions from the MotorState message."""
+        self.current_motor_pos = list(msg.position)
 
     def is_at_target_config(self, target_config):
         """Checks if the robot's motors are within the threshold of the home position."""
@@ -0,0 +1,136 @@
+#ifndef LATENCY_HISTOGRAM_HPP_
+#define LATENCY_HISTOGRAM_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <time.h>
+
+// Log-linear latency histogram in nanoseconds, laid out like HdrHistogram: 32 linear buckets per
+// power of two (about 3 % resolution) from 1 ns up to ~137 s, larger values land in the last bucket.
+// record() is wait-free and allocation-free, one relaxed add per counter, so any thread (including
+// the real-time ones) can record. Readers take a Snapshot; counters are never torn, but a snapshot
+// taken while a thread records may be off by that one sample.
+class LatencyHistogram
+{
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAX_EXPONENT = 36;                 // Highest power of two with its own buckets
+    static constexpr int NUM_BUCKETS = SUB_BUCKETS + (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    struct Snapshot {
+        uint64_t counts[NUM_BUCKETS];
+        uint64_t total;
+        uint64_t sum_ns;
+
+        // percentile in [0, 100]; 0 when there are no samples
+        int64_t percentileNs(double percentile) const
+        {
+            if (total == 0) {
+                return 0;
+            }
+            uint64_t rank = (uint64_t)(percentile / 100.0 * (double)total + 0.5);
+            rank = (rank < 1) ? 1 : (rank > total ? total : rank);
+            uint64_t seen = 0;
+            for (int i = 0; i < NUM_BUCKETS; i++) {
+                seen += counts[i];
+                if (seen >= rank) {
+                    return bucketUpperNs(i);
+                }
+            }
+            return bucketUpperNs(NUM_BUCKETS - 1);
+        }
+
+        int64_t maxNs() const
+        {
+            for (int i = NUM_BUCKETS - 1; i >= 0; i--) {
+                if (counts[i] != 0) {
+                    return bucketUpperNs(i);
+                }
+            }
+            return 0;
+        }
+
+        double meanNs() const { return total ? (double)sum_ns / (double)total : 0.0; }
+
+        // Leaves only the samples recorded after `earlier` was taken
+        void subtract(const Snapshot& earlier)
+        {
+            for (int i = 0; i < NUM_BUCKETS; i++) {
+                counts[i] -= earlier.counts[i];
+            }
+            total -= earlier.total;
+            sum_ns -= earlier.sum_ns;
+        }
+    };
+
+    void record(int64_t value_ns)
+    {
+        uint64_t value = (value_ns > 0) ? (uint64_t)value_ns : 0;
+        counts_[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        sum_ns_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void snapshot(Snapshot* out) const
+    {
+        uint64_t total = 0;
+        for (int i = 0; i < NUM_BUCKETS; i++) {
+            out->counts[i] = counts_[i].load(std::memory_order_relaxed);
+            total += out->counts[i];
+        }
+        out->total = total;
+        out->sum_ns = sum_ns_.load(std::memory_order_relaxed);
+    }
+
+    static int bucketIndex(uint64_t value)
+    {
+        if (value < (uint64_t)SUB_BUCKETS) {
+            return (int)value;
+        }
+        int msb = 63 - __builtin_clzll(value);
+        if (msb > MAX_EXPONENT) {
+            return NUM_BUCKETS - 1;
+        }
+        int shift = msb - SUB_BUCKET_BITS;
+        return SUB_BUCKETS + shift * SUB_BUCKETS + (int)((value >> shift) - SUB_BUCKETS);
+    }
+
+    // Largest value that falls into bucket index
+    static int64_t bucketUpperNs(int index)
+    {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        int shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+        int64_t sub = SUB_BUCKETS + (index - SUB_BUCKETS) % SUB_BUCKETS;
+        return ((sub + 1) << shift) - 1;
+    }
+
+private:
+    std::atomic<uint64_t> counts_[NUM_BUCKETS] = {};
+    std::atomic<uint64_t> sum_ns_{0};
+};
+
+inline int64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Records the time from construction to the end of the enclosing scope
+class ScopedLatency
+{
+public:
+    explicit ScopedLatency(LatencyHistogram& histogram) : histogram_(histogram), start_ns_(monotonicNs()) {}
+    ~ScopedLatency() { histogram_.record(monotonicNs() - start_ns_); }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    LatencyHistogram& histogram_;
+    int64_t start_ns_;
+};
+
+#endif  // LATENCY_HISTOGRAM_HPP_
@@ -0,0 +1,97 @@
+#ifndef ORIENTATION_FILTER_HPP_
+#define ORIENTATION_FILTER_HPP_
+
+#include <cmath>
+
+// Wraps an angle to [-180, 180)
+inline float wrapDegrees(float angle)
+{
+    angle = std::fmod(angle + 180.0f, 360.0f);
+    if (angle < 0.0f) {
+        angle += 360.0f;
+    }
+    return angle - 180.0f;
+}
+
+// True if angle lies on the arc going up from `from` to `to`, which may cross +-180
+// (e.g. angleInRange(a, 123, -122) is the 115 degrees around 180)
+inline bool angleInRange(float angle, float from, float to)
+{
+    float span = wrapDegrees(to - from);
+    if (span < 0.0f) {
+        span += 360.0f;
+    }
+    float offset = wrapDegrees(angle - from);
+    if (offset < 0.0f) {
+        offset += 360.0f;
+    }
+    return offset <= span;
+}
+
+// Roll about the x-axis from gyro x and the gravity direction in the y-z plane.
+// Mahony-style complementary filter reduced to one axis: the gyro is integrated every step and
+// the accelerometer pulls the estimate back with a proportional term (time constant 1/kp) and
+// an integral term that tracks the gyro bias. The accelerometer is trusted less the further its
+// magnitude is from 1 g, so centripetal acceleration while rolling does not drag the estimate.
+// Fixed step, no allocation; call update() once per sample from a single thread.
+class RollFilter
+{
+public:
+    RollFilter(float kp = 2.0f, float ki = 0.1f, float max_step_s = 0.1f)
+        : kp_(kp), ki_(ki), max_step_s_(max_step_s), initialized_(false), roll_(0.0f), rate_(0.0f), bias_(0.0f) {}
+
+    // gyro_x in deg/s, accel in any consistent unit (only the direction and ratio to 1 g matter)
+    void update(float gyro_x, float accel_x, float accel_y, float accel_z, float gravity, float dt)
+    {
+        float accel_roll = std::atan2(accel_y, accel_z) * (180.0f / (float)M_PI);
+        float weight = accelWeight(accel_x, accel_y, accel_z, gravity);
+
+        // First sample, or a gap too long to integrate across: start again from gravity
+        if (!initialized_ || dt <= 0.0f || dt > max_step_s_) {
+            if (weight > 0.0f || !initialized_) {
+                roll_ = wrapDegrees(accel_roll);
+            }
+            rate_ = gyro_x - bias_;
+            initialized_ = true;
+            return;
+        }
+
+        float error = wrapDegrees(accel_roll - roll_) * weight;   // Shortest way round, across +-180
+        bias_ -= ki_ * error * dt;
+        rate_ = gyro_x - bias_;
+        roll_ = wrapDegrees(roll_ + (rate_ + kp_ * error) * dt);
+    }
+
+    void reset() { initialized_ = false; bias_ = 0.0f; }
+
+    float rollDegrees() const { return roll_; }        // [-180, 180)
+    float rateDps() const { return rate_; }             // Bias-corrected roll rate
+    float biasDps() const { return bias_; }
+    bool isInitialized() const { return initialized_; }
+    float maxStepS() const { return max_step_s_; }      // Longer gaps restart from gravity
+
+private:
+    // 1 within 10 % of 1 g, fading to 0 at 30 %
+    static float accelWeight(float accel_x, float accel_y, float accel_z, float gravity)
+    {
+        float magnitude = std::sqrt(accel_x * accel_x + accel_y * accel_y + accel_z * accel_z);
+        float deviation = std::fabs(magnitude - gravity) / gravity;
+        if (deviation <= 0.1f) {
+            return 1.0f;
+        }
+        if (deviation >= 0.3f) {
+            return 0.0f;
+        }
+        return (0.3f - deviation) / 0.2f;
+    }
+
+    float kp_;
+    float ki_;
+    float max_step_s_;
+    bool initialized_;
+    float roll_;
+    float rate_;
+    float bias_;
+};
+
+#endif  // ORIENTATION_FILTER_HPP_
@@ -4,6 +4,23 @@
 #include <iostream>
 
 #define NUM_MOTORS 12
+#include "trajectory_profile.hpp"
+
+// How quad_motor_control moves through each config (-1 / -2 = yellow / blue roll).
+// SERVO_PROFILE sends one Sync Write per step and lets the servos interpolate; it falls back
+// to HOST_INTERPOLATION when the servo_profile parameter is off or time-based profiles are unavailable.
+MotionMode get_config_motion_mode(int config_id) {
+    switch (config_id) {
+        case 3:     // Home to Cir
+        case 4:     // Cir to Home
+        case -1:    // Roll yellow
+        case -2:    // Roll blue
+            return MotionMode::SERVO_PROFILE;
+        default:    // Single poses and turning steps jump to each pose
+            return MotionMode::HOST_INTERPOLATION;
+    }
+}
+
 // Function to copy array
 void copy_array(int* dest, const int* src) {
     for (int i = 0; i <= NUM_MOTORS; i++) {
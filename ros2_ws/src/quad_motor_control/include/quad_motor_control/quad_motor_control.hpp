@@ -1,9 +1,12 @@
 #ifndef QUAD_MOTOR_CONTROL_HPP_
 #define QUAD_MOTOR_CONTROL_HPP_
 
+#include <atomic>
 #include <cstdio>
 #include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "rclcpp/rclcpp.hpp"
 #include "rcutils/cmdline_parser.h"
@@ -13,10 +16,18 @@
 #include "quad_interfaces/srv/get_position.hpp"
 #include "quad_interfaces/srv/get_all_positions.hpp"
 
+#include "quad_interfaces/msg/loop_timing.hpp"
 #include "quad_interfaces/msg/motor_positions.hpp"
+#include "quad_interfaces/msg/motor_state.hpp"
 #include "quad_interfaces/msg/robot_state.hpp"  
+#include "quad_interfaces/msg/trajectory_progress.hpp"
 
+#include "latency_histogram.hpp"
+#include "orientation_filter.hpp"
 #include "position_configs.hpp"
+#include "realtime_utils.hpp"
+#include "roll_push_scheduler.hpp"
+#include "trajectory_executor.hpp"
 // #include <vector>
 
 
@@ -34,6 +45,61 @@ enum class RobotStateEnum {
     STOPPED_ROLLING = 7
 };
 
+// One gyroscope + accelerometer reading in raw counts
+struct ImuSample {
+    int16_t gyro_x, gyro_y, gyro_z;
+    int16_t accel_x, accel_y, accel_z;
+};
+
+// Timestamped IMU sample pushed by the IMU thread
+struct ImuReading {
+    int64_t stamp_ns;                       // CLOCK_MONOTONIC at the end of the I2C read
+    ImuSample raw;
+    float tilt_deg;                         // Fused roll about the x-axis, -180 to 180
+    float roll_rate_dps;                    // Bias-corrected gyro roll rate
+};
+
+// Timed sections of the node's loops, one latency histogram each
+enum class LoopStage : int {
+    CONTROL_TICK = 0,       // Control thread work per tick, wakeup to sleep
+    CONTROL_JITTER = 1,     // How late the control thread woke up
+    BUS_WRITE = 2,          // Goal / profile Sync Write
+    BUS_READ = 3,           // State Sync Read
+    IMU_READ = 4,           // I2C sample read or FIFO drain
+    PUBLISH = 5,            // Motor state / position publishing
+    COUNT = 6
+};
+
+// Command handed from ROS callbacks to the control thread
+struct MotorCommand {
+    enum Type : uint8_t {
+        SET_POSITION = 0,   // Change the goal of one motor, stopping any running trajectory
+        KEYFRAME = 1        // One step of a trajectory
+    };
+    Type type;
+    uint8_t id;                             // SET_POSITION only
+    int32_t position;                       // SET_POSITION only
+    uint32_t trajectory_id;                 // KEYFRAME: a new id preempts the running trajectory
+    int32_t config_id;                      // KEYFRAME: reported in the progress
+    uint16_t num_steps;                     // KEYFRAME: length of the whole trajectory
+    Keyframe keyframe;                      // KEYFRAME only
+};
+
+// State published by the control thread every tick
+struct MotorStateSnapshot {
+    int32_t present_positions[NUM_MOTORS + 1];
+    int32_t present_velocities[NUM_MOTORS + 1];
+    int16_t present_currents[NUM_MOTORS + 1];
+    uint16_t input_voltages[NUM_MOTORS + 1];    // 0.1 V
+    uint8_t temperatures[NUM_MOTORS + 1];       // deg C
+    uint8_t hardware_errors[NUM_MOTORS + 1];    // Hardware Error Status (status packet error byte without the indirect block)
+    int32_t goal_positions[NUM_MOTORS + 1];
+    int read_result;                        // COMM_* result of the last state read
+    int64_t read_stamp_ns;                  // CLOCK_MONOTONIC when the last state read completed
+    int64_t read_latency_ns;
+    uint64_t tick;
+};
+
 class QuadMotorControl : public rclcpp::Node 
 {
 public:
@@ -50,28 +116,37 @@ public:
 private:
     // IMU related variables
     int i2c_file;
-    float accumulated_tilt_angle;
-    int sample_count;
-    const int window_size = 2;  // Number of samples to average
     
     // IMU functions
     void initIMU();
     int write_register(uint8_t reg, uint8_t value);
     int read_register(uint8_t reg);
-    int16_t read_16bit_register(uint8_t reg_low, uint8_t reg_high);
-    float getTiltAngle();
+    int readImuRegisters(uint8_t reg, uint8_t* data, uint16_t length);  // One I2C_RDWR transaction
+    int readImuSample(ImuSample* sample);           // All six axes in one I2C transaction
+    bool configureImuFifo();
+    int drainImuFifo(ImuSample* samples, int max_samples);  // Oldest first; -1 on error
+    bool getLatestImuReading(ImuReading* reading) const;   // Lock-free, any thread
+    void checkRollOrientation();
 
     void execute_roll_yellow();
     void execute_roll_blue();
+    void schedule_roll_push(RollSide side, uint32_t delay_ms);  // Propel after delay_ms, then back to perfect_cir
 
-    void gradual_transition(int* next_positions);
-    void update_present_positions();
+    Keyframe gradual_transition(int* next_positions, int hold_ms = 0);
+    int readMotorState(MotorStateSnapshot* state);  // One sync read transaction for all motors
 
     // DYNAMIXEL SDK components
     dynamixel::PortHandler* portHandler;
     dynamixel::PacketHandler* packetHandler;
     dynamixel::GroupSyncWrite* groupSyncWrite;
+    dynamixel::GroupSyncWrite* groupProfileWrite;   // Profile Acceleration + Profile Velocity + Goal Position
     dynamixel::GroupSyncRead* groupSyncRead;
+    dynamixel::GroupFastSyncRead* groupFastSyncRead;  // Same object as groupSyncRead when use_fast_sync_read is set
+    bool use_fast_sync_read_;
+    bool indirect_state_;                           // State read from the indirect data block
+    int baud_rate_;
+    bool baud_autotune_;                            // Find motors at any baud and switch them to baud_rate_
+    int return_delay_us_;
 
     // ROS2 Components
     rclcpp::Subscription<SetPosition>::SharedPtr set_position_subscriber_;
@@ -80,19 +155,103 @@ private:
     rclcpp::Service<GetAllPositions>::SharedPtr get_all_positions_server_;
 
     rclcpp::TimerBase::SharedPtr timer_;
+    rclcpp::TimerBase::SharedPtr roll_check_timer_;
     rclcpp::Publisher<quad_interfaces::msg::MotorPositions>::SharedPtr motor_positions_publisher_;
+    rclcpp::TimerBase::SharedPtr motor_state_timer_;
+    rclcpp::Publisher<quad_interfaces::msg::MotorState>::SharedPtr motor_state_publisher_;
+    int64_t last_published_state_ns_ = 0;
+
+    // Loop timing: recorded by every thread, reported on /loop_timing and logged on SIGUSR1
+    void publishLoopTiming();
+    void logLoopTiming();
+    LatencyHistogram& stageLatency(LoopStage stage) { return stage_latency_[static_cast<int>(stage)]; }
+    LatencyHistogram stage_latency_[static_cast<int>(LoopStage::COUNT)];
+    LatencyHistogram::Snapshot last_timing_[static_cast<int>(LoopStage::COUNT)] = {};  // Executor thread only
+    rclcpp::Publisher<quad_interfaces::msg::LoopTiming>::SharedPtr loop_timing_publisher_;
+    rclcpp::TimerBase::SharedPtr loop_timing_timer_;
+    rclcpp::TimerBase::SharedPtr timing_dump_timer_;
 
     // Helper functions
     void initDynamixels();
     void publishMotorPositions();
+    void publishMotorState();
     void executeConfiguration(const SetConfig::SharedPtr msg);
     int readMotorPosition(int motor_id);
 
     // **Configuration Execution and Motor Control**
     void execute_config(int config_id);              // Executes a predefined configuration
-    void apply_motor_positions(int* target_positions);  // Moves motors to a target position immediately
-    
-    int present_position;
+    void apply_motor_positions(int* target_positions);  // Moves motors to a target position immediately (control thread only)
+    void apply_servo_profile_move(int* target_positions, uint32_t accel_ms, uint32_t duration_ms);  // Servo-side move (control thread only)
+    bool enableTimeBasedProfile();
+    bool configureIndirectState();
+    bool configureBus();                            // Move every motor to baud_rate_ / return_delay_us_
+    double tickBusTime(int read_length, int return_delay_us) const;  // Seconds
+    void fitControlRateToBus();                     // Lowers control_rate_hz_ / drops indirect_state_ to fit the bus
+
+    // **Real-time control thread** (owns the serial bus once started)
+    void startControlLoop();
+    void stopControlLoop();
+    void controlLoop();
+    void configureRealtime(const char* thread_name, int priority, int cpu);  // cpu -1 = do not pin
+    void processCommands(int64_t now_ns);
+    bool enqueueCommand(const MotorCommand& command);
+    bool enqueueTrajectory(int config_id, const std::vector<Keyframe>& keyframes);
+    bool isMotionIdle() const;
+    void publishTrajectoryProgress();
+    void initMotionProfile();
+
+    int control_rate_hz_;
+    int motor_state_rate_hz_;
+    int rt_priority_;
+    int cpu_affinity_;                              // -1 = do not pin
+    std::thread control_thread_;
+    std::atomic<bool> control_running_{false};
+    std::atomic<bool> trajectory_active_{false};
+
+    // Filled by ROS callbacks on the executor thread, drained by the control thread
+    SpscQueue<MotorCommand, 64> command_queue_;
+    SeqLock<MotorStateSnapshot> state_snapshot_;
+    SeqLock<TrajectoryProgress> progress_snapshot_;
+    uint32_t next_trajectory_id_ = 0;               // Executor thread only
+
+    // **IMU thread** (owns the I2C bus once started)
+    void startImuLoop();
+    void stopImuLoop();
+    void imuLoop();
+
+    int imu_rate_hz_;
+    int imu_rt_priority_;
+    double imu_filter_kp_;                          // 1/s, pull towards the accelerometer roll
+    double imu_filter_ki_;                          // 1/s^2, gyro bias tracking
+    bool imu_fifo_enabled_;                         // Batch samples in the IMU FIFO when the sensor has one
+    int imu_fifo_watermark_;                        // Samples per batch
+    bool imu_fifo_active_ = false;
+    ImuSample imu_fifo_pending_{};                  // IMU thread only
+    std::thread imu_thread_;
+    std::atomic<bool> imu_running_{false};
+    SpmcRing<ImuReading, 256> imu_ring_;            // About 0.6 s of history at 416 Hz
+
+    // Rolling: pushes timed from the predicted roll (executor thread only)
+    bool roll_predictive_;
+    int roll_push_hold_ms_;
+    RollPushScheduler roll_scheduler_{RollPushScheduler::Params{}};
+
+    rclcpp::TimerBase::SharedPtr progress_timer_;
+    rclcpp::Publisher<quad_interfaces::msg::TrajectoryProgress>::SharedPtr trajectory_progress_publisher_;
+    TrajectoryProgress last_published_progress_{};
+
+    ProfileType motion_profile_ = ProfileType::MIN_JERK;
+    bool servo_profile_enabled_ = true;             // Cleared when the servos cannot use time-based profiles
+
+    // Control thread state
+    TrajectoryExecutor executor_;
+    int goal_positions_[NUM_MOTORS + 1] = {0};
+    bool goals_initialized_ = false;
+    bool goals_dirty_ = false;                      // Goal changed outside the executor (set_position)
+    bool servo_profile_active_ = true;              // Servos may hold a non-zero profile (also from a previous run)
+    uint64_t tick_count_ = 0;
+    std::atomic<uint64_t> overrun_count_{0};
+
     int last_executed_config_;
     
     RobotStateEnum curr_robot_state_;  // Track the robot's current state as an enum
@@ -0,0 +1,167 @@
+#ifndef REALTIME_UTILS_HPP_
+#define REALTIME_UTILS_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Lock-free single-producer single-consumer ring.
+// The producer only calls push(), the consumer only calls front()/pop(); neither side
+// blocks or allocates, so the consumer can be the real-time control thread.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Returns false when the queue is full
+    bool push(const T& item)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        buffer_[head & (Capacity - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Oldest item, or nullptr when the queue is empty. Valid until pop().
+    T* front()
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &buffer_[tail & (Capacity - 1)];
+    }
+
+    void pop()
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool empty() const
+    {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    // Free slots. Exact for the producer: only the consumer changes it meanwhile, and only upwards.
+    size_t available() const
+    {
+        return Capacity - (head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_acquire));
+    }
+
+private:
+    alignas(64) std::atomic<size_t> head_{0};  // Written by the producer
+    alignas(64) std::atomic<size_t> tail_{0};  // Written by the consumer
+    T buffer_[Capacity];
+};
+
+// Sequence lock for publishing a snapshot from one writer to any number of readers.
+// The writer never waits; readers retry if they raced with a store.
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock value must be trivially copyable");
+
+public:
+    void store(const T& value)
+    {
+        uint32_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);     // Odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        value_ = value;
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    T load() const
+    {
+        T value;
+        uint32_t before, after;
+        do {
+            before = seq_.load(std::memory_order_acquire);
+            value = value_;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = seq_.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        return value;
+    }
+
+private:
+    std::atomic<uint32_t> seq_{0};
+    T value_{};
+};
+
+// Single-producer multi-consumer broadcast ring.
+// The producer overwrites the oldest entry and never waits. Every consumer keeps its own
+// index (0, 1, 2, ... up to head()) and detects entries that were overwritten before it got
+// to them. Each slot carries its own sequence number, so reads are lock-free.
+template <typename T, size_t Capacity>
+class SpmcRing
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "SpmcRing entries must be trivially copyable");
+
+public:
+    void push(const T& item)
+    {
+        uint64_t index = head_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[index & (Capacity - 1)];
+        slot.seq.store(2 * index + 1, std::memory_order_relaxed);     // Odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.value = item;
+        slot.seq.store(2 * index + 2, std::memory_order_release);
+        head_.store(index + 1, std::memory_order_release);
+    }
+
+    // Number of entries pushed so far; the next one gets this index
+    uint64_t head() const
+    {
+        return head_.load(std::memory_order_acquire);
+    }
+
+    // Copies entry index into item. Returns false if it is not written yet or was overwritten.
+    bool read(uint64_t index, T* item) const
+    {
+        const Slot& slot = slots_[index & (Capacity - 1)];
+        uint64_t before = slot.seq.load(std::memory_order_acquire);
+        if (before != 2 * index + 2) {
+            return false;
+        }
+        *item = slot.value;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.seq.load(std::memory_order_relaxed) == before;
+    }
+
+    // Newest entry; false only when nothing has been pushed yet
+    bool latest(T* item) const
+    {
+        uint64_t head;
+        while ((head = this->head()) > 0) {
+            if (read(head - 1, item)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Oldest index a consumer can still read
+    uint64_t oldest() const
+    {
+        uint64_t head = this->head();
+        return (head > Capacity) ? head - Capacity + 1 : 0;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        T value{};
+    };
+
+    alignas(64) std::atomic<uint64_t> head_{0};
+    Slot slots_[Capacity];
+};
+
+#endif  // REALTIME_UTILS_HPP_
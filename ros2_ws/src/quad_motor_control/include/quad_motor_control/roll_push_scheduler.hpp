@@ -0,0 +1,86 @@
+#ifndef ROLL_PUSH_SCHEDULER_HPP_
+#define ROLL_PUSH_SCHEDULER_HPP_
+
+#include <cmath>
+
+#include "orientation_filter.hpp"
+
+enum class RollSide : int {
+    NONE = 0,
+    YELLOW = 1,
+    BLUE = 2
+};
+
+// Predicts when the rolling body reaches the push angle of each side and says when to start the
+// push so that, after the bus and servo latency, the legs move at that angle.
+// Called periodically (every few ms) with the latest fused roll; owns no clock and no threads.
+class RollPushScheduler
+{
+public:
+    struct Params {
+        float yellow_angle_deg;     // Roll at which the yellow push should act
+        float blue_angle_deg;       // Roll at which the blue push should act
+        float latency_s;            // From enqueueing the push to the legs moving
+        float horizon_s;            // Pushes due within this long are scheduled now
+        float late_tolerance_s;     // A push this late is still worth sending
+        float min_rate_dps;         // Below this the roll is not predictable
+    };
+
+    explicit RollPushScheduler(const Params& params) : params_(params), yellow_armed_(true), blue_armed_(true) {}
+
+    // Returns the side to push and, in *delay_s, how long to wait before starting it.
+    // roll_deg/rate_dps must already be extrapolated to the time of the call.
+    RollSide update(float roll_deg, float rate_dps, float* delay_s)
+    {
+        // A side can be pushed again once the body has turned well away from its push angle
+        if (std::fabs(wrapDegrees(roll_deg - params_.yellow_angle_deg)) > 90.0f) yellow_armed_ = true;
+        if (std::fabs(wrapDegrees(roll_deg - params_.blue_angle_deg)) > 90.0f) blue_armed_ = true;
+
+        if (std::fabs(rate_dps) < params_.min_rate_dps) {
+            return RollSide::NONE;
+        }
+
+        float yellow_delay = yellow_armed_ ? pushDelay(roll_deg, rate_dps, params_.yellow_angle_deg) : INFINITY;
+        float blue_delay = blue_armed_ ? pushDelay(roll_deg, rate_dps, params_.blue_angle_deg) : INFINITY;
+        RollSide side = (yellow_delay <= blue_delay) ? RollSide::YELLOW : RollSide::BLUE;
+        float delay = std::fmin(yellow_delay, blue_delay);
+        if (delay > params_.horizon_s || delay < -params_.late_tolerance_s) {
+            return RollSide::NONE;
+        }
+
+        (side == RollSide::YELLOW ? yellow_armed_ : blue_armed_) = false;
+        *delay_s = std::fmax(0.0f, delay);
+        return side;
+    }
+
+    // A push was started some other way (e.g. from rest); do not schedule that side again yet
+    void markPushed(RollSide side)
+    {
+        if (side == RollSide::YELLOW) yellow_armed_ = false;
+        if (side == RollSide::BLUE) blue_armed_ = false;
+    }
+
+    float minRateDps() const { return params_.min_rate_dps; }
+
+    // Time until the push towards target_deg has to start; negative if it should have started already
+    float pushDelay(float roll_deg, float rate_dps, float target_deg) const
+    {
+        // Angle still to turn in the direction of rotation, [0, 360)
+        float remaining = wrapDegrees((rate_dps > 0.0f) ? target_deg - roll_deg : roll_deg - target_deg);
+        if (remaining < 0.0f) {
+            remaining += 360.0f;
+        }
+        float delay = remaining / std::fabs(rate_dps) - params_.latency_s;
+
+        // Just past the target reads as almost a full turn away: count it as late instead
+        float late = delay - 360.0f / std::fabs(rate_dps);
+        return (late >= -params_.late_tolerance_s) ? late : delay;
+    }
+
+private:
+    Params params_;
+    bool yellow_armed_;
+    bool blue_armed_;
+};
+
+#endif  // ROLL_PUSH_SCHEDULER_HPP_
@@ -0,0 +1,212 @@
+#ifndef TRAJECTORY_EXECUTOR_HPP_
+#define TRAJECTORY_EXECUTOR_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "trajectory_profile.hpp"
+
+#define MAX_KEYFRAMES 32
+#define KEYFRAME_TIME_OPTIMAL 0xFFFFFFFF    // move_ms: as fast as the joint limits allow
+
+// One step of a trajectory: move to positions over move_ms, then hold them for hold_ms
+struct Keyframe {
+    int32_t positions[NUM_MOTORS + 1];      // Indexed by motor ID
+    uint32_t move_ms;                       // 0 = jump to the positions
+    uint32_t hold_ms;
+    ProfileType profile;                    // HOST_INTERPOLATION only; the servo profile is trapezoidal
+    MotionMode mode;
+};
+
+struct TrajectoryProgress {
+    enum Status : uint8_t {
+        IDLE = 0,
+        RUNNING = 1,
+        DONE = 2,
+        PREEMPTED = 3
+    };
+    uint32_t trajectory_id;
+    int32_t config_id;
+    uint8_t status;
+    uint16_t step;                          // Keyframe being executed (0-based)
+    uint16_t num_steps;
+    float step_fraction;                    // Progress through the move and hold of the step, 0-1
+};
+
+// Runs a keyframe trajectory against a monotonic clock in nanoseconds.
+// Each step ends at an absolute deadline counted from the start of the trajectory, so a late
+// update skips ahead instead of stretching the sequence. Owned and called by one thread.
+class TrajectoryExecutor
+{
+public:
+    TrajectoryExecutor() : count_(0), step_start_ns_(0), step_ns_(0), step_prepared_(false),
+        servo_move_pending_(false), servo_accel_ms_(0), servo_duration_ms_(0)
+    {
+        progress_ = TrajectoryProgress{0, 0, TrajectoryProgress::IDLE, 0, 0, 0.0f};
+        scaling_ = TimeScaling::fixed(ProfileType::LINEAR, 0.0f);
+        for (int id = 0; id <= NUM_MOTORS; id++) {
+            limits_[id] = JointLimits{INFINITY, INFINITY};
+        }
+    }
+
+    // Velocity and acceleration limits used for KEYFRAME_TIME_OPTIMAL moves, indexed by motor ID
+    void setLimits(const JointLimits* limits)
+    {
+        std::copy(limits, limits + NUM_MOTORS + 1, limits_);
+    }
+
+    // Starts a new trajectory from the current goals, preempting the one that is running
+    void begin(uint32_t trajectory_id, int32_t config_id, uint16_t num_steps, int64_t now_ns, const int* current_goals)
+    {
+        count_ = 0;
+        step_start_ns_ = now_ns;
+        step_prepared_ = false;
+        servo_move_pending_ = false;
+        std::copy(current_goals, current_goals + NUM_MOTORS + 1, step_from_);
+        progress_.trajectory_id = trajectory_id;
+        progress_.config_id = config_id;
+        progress_.status = TrajectoryProgress::RUNNING;
+        progress_.step = 0;
+        progress_.num_steps = std::min<uint16_t>(num_steps, MAX_KEYFRAMES);
+        progress_.step_fraction = 0.0f;
+    }
+
+    // Appends the next step of the trajectory started by begin() with the same id
+    bool append(uint32_t trajectory_id, const Keyframe& keyframe)
+    {
+        if (progress_.status != TrajectoryProgress::RUNNING || trajectory_id != progress_.trajectory_id ||
+            count_ >= progress_.num_steps) {
+            return false;
+        }
+        keyframes_[count_++] = keyframe;
+        return true;
+    }
+
+    // Stops where the goals are now
+    void cancel()
+    {
+        if (progress_.status == TrajectoryProgress::RUNNING) {
+            progress_.status = TrajectoryProgress::PREEMPTED;
+        }
+    }
+
+    // Writes the goals for now_ns; returns true if any of them changed
+    bool update(int64_t now_ns, int* goals)
+    {
+        if (progress_.status != TrajectoryProgress::RUNNING) {
+            return false;
+        }
+
+        bool changed = false;
+        int64_t elapsed_ns = 0;
+        while (progress_.step < count_) {
+            const Keyframe& keyframe = keyframes_[progress_.step];
+            if (!step_prepared_) {
+                prepareStep(keyframe);
+            }
+            elapsed_ns = now_ns - step_start_ns_;
+            if (elapsed_ns < step_ns_) {
+                break;
+            }
+
+            // Step over: land exactly on its positions and start the next one at its deadline
+            changed |= setGoals(keyframe.positions, goals);
+            std::copy(keyframe.positions, keyframe.positions + NUM_MOTORS + 1, step_from_);
+            step_start_ns_ += step_ns_;
+            step_prepared_ = false;
+            progress_.step++;
+        }
+
+        if (progress_.step >= progress_.num_steps) {
+            progress_.step = (progress_.num_steps > 0) ? progress_.num_steps - 1 : 0;
+            progress_.step_fraction = 1.0f;
+            progress_.status = TrajectoryProgress::DONE;
+            return changed;
+        }
+        if (progress_.step >= count_) {         // Next step not received yet: hold
+            return changed;
+        }
+
+        // Every joint follows the same s(t) from where the step started, so they arrive together
+        const Keyframe& keyframe = keyframes_[progress_.step];
+        if (keyframe.mode == MotionMode::SERVO_PROFILE) {
+            // The servo moves to the target itself; the goals are the target for the whole step
+            changed |= setGoals(keyframe.positions, goals);
+            progress_.step_fraction = (step_ns_ > 0) ? (float)elapsed_ns / step_ns_ : 1.0f;
+            return changed;
+        }
+
+        float s = scaling_.position(elapsed_ns * 1e-9f);
+        int interpolated[NUM_MOTORS + 1];
+        for (int id = 0; id <= NUM_MOTORS; id++) {
+            interpolated[id] = step_from_[id] + (int)std::lround(s * (keyframe.positions[id] - step_from_[id]));
+        }
+        changed |= setGoals(interpolated, goals);
+        progress_.step_fraction = (step_ns_ > 0) ? (float)elapsed_ns / step_ns_ : 1.0f;
+        return changed;
+    }
+
+    // Profile of a SERVO_PROFILE step that has started since the last call, in the time-based
+    // units of the X series: Profile Acceleration = ramp time, Profile Velocity = move time (ms)
+    bool takeServoMove(uint32_t* accel_ms, uint32_t* duration_ms)
+    {
+        if (!servo_move_pending_) {
+            return false;
+        }
+        servo_move_pending_ = false;
+        *accel_ms = servo_accel_ms_;
+        *duration_ms = servo_duration_ms_;
+        return true;
+    }
+
+    bool isRunning() const { return progress_.status == TrajectoryProgress::RUNNING; }
+    const TrajectoryProgress& progress() const { return progress_; }
+
+private:
+    // Times the move of the step that starts now from step_from_
+    void prepareStep(const Keyframe& keyframe)
+    {
+        ProfileType profile = (keyframe.mode == MotionMode::SERVO_PROFILE) ? ProfileType::TRAPEZOIDAL : keyframe.profile;
+        if (keyframe.move_ms == KEYFRAME_TIME_OPTIMAL) {
+            scaling_ = TimeScaling::timeOptimal(profile, step_from_, keyframe.positions, limits_);
+        } else {
+            scaling_ = TimeScaling::fixed(profile, keyframe.move_ms * 1e-3f);
+        }
+        step_ns_ = (int64_t)std::ceil(scaling_.duration * 1e9f) + (int64_t)keyframe.hold_ms * 1000000;
+        step_prepared_ = true;
+
+        if (keyframe.mode == MotionMode::SERVO_PROFILE) {
+            servo_move_pending_ = true;
+            servo_duration_ms_ = (uint32_t)std::ceil(scaling_.duration * 1000.0f);
+            servo_accel_ms_ = std::min((uint32_t)std::lround(scaling_.accel_time * 1000.0f), servo_duration_ms_ / 2);
+        }
+    }
+
+    static bool setGoals(const int* positions, int* goals)
+    {
+        bool changed = false;
+        for (int id = 1; id <= NUM_MOTORS; id++) {
+            if (goals[id] != positions[id]) {
+                goals[id] = positions[id];
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    Keyframe keyframes_[MAX_KEYFRAMES];
+    uint16_t count_;                        // Steps received so far
+    int64_t step_start_ns_;                 // Start of the current step
+    int step_from_[NUM_MOTORS + 1];         // Goals when the current step started
+    int64_t step_ns_;                       // Move plus hold of the current step
+    bool step_prepared_;
+    TimeScaling scaling_;                   // Move of the current step
+    JointLimits limits_[NUM_MOTORS + 1];
+    bool servo_move_pending_;
+    uint32_t servo_accel_ms_;
+    uint32_t servo_duration_ms_;
+    TrajectoryProgress progress_;
+};
+
+#endif  // TRAJECTORY_EXECUTOR_HPP_
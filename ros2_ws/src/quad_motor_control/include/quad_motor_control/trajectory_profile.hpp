@@ -0,0 +1,129 @@
+#ifndef TRAJECTORY_PROFILE_HPP_
+#define TRAJECTORY_PROFILE_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#ifndef NUM_MOTORS
+#define NUM_MOTORS 12
+#endif
+
+enum class ProfileType : uint8_t {
+    LINEAR = 0,         // Constant velocity; ignores the acceleration limit
+    MIN_JERK = 1,       // s = 10t^3 - 15t^4 + 6t^5, zero velocity and acceleration at both ends
+    TRAPEZOIDAL = 2     // Constant acceleration, cruise, constant deceleration
+};
+
+// Where the moves of a trajectory step are interpolated
+enum class MotionMode : uint8_t {
+    HOST_INTERPOLATION = 0,     // The control thread streams goal positions every tick
+    SERVO_PROFILE = 1           // One write of Profile Acceleration/Velocity + Goal Position; the servo interpolates
+};
+
+// Limits of one joint in position ticks
+struct JointLimits {
+    float max_velocity;         // ticks/s
+    float max_acceleration;     // ticks/s^2
+};
+
+// Time scaling s(t) from 0 to 1 shared by every joint of a move, so they all arrive together.
+// All joints follow the same straight line in joint space: joint i is at start + s(t) * distance_i.
+struct TimeScaling {
+    ProfileType type;
+    float duration;             // s
+    float accel_time;           // s, TRAPEZOIDAL only
+    float peak_rate;            // 1/s, peak ds/dt for TRAPEZOIDAL
+
+    // Duration of the fastest move that keeps every joint within its limits.
+    // min_duration is used when the limits allow an even faster move (or nothing moves).
+    static TimeScaling timeOptimal(ProfileType type, const int* from, const int* to,
+                                   const JointLimits* limits, float min_duration = 0.0f)
+    {
+        // Normalised limits: the most constraining joint sets how fast s may change
+        float rate_limit = INFINITY, accel_limit = INFINITY;
+        for (int id = 1; id <= NUM_MOTORS; id++) {
+            float distance = std::fabs((float)(to[id] - from[id]));
+            if (distance < 1.0f) {
+                continue;
+            }
+            rate_limit = std::min(rate_limit, limits[id].max_velocity / distance);
+            accel_limit = std::min(accel_limit, limits[id].max_acceleration / distance);
+        }
+
+        TimeScaling scaling{type, min_duration, 0.0f, 0.0f};
+        if (std::isinf(rate_limit)) {
+            return finish(scaling);
+        }
+
+        switch (type) {
+        case ProfileType::LINEAR:
+            scaling.duration = std::max(min_duration, 1.0f / rate_limit);
+            break;
+        case ProfileType::MIN_JERK:
+            // Peak ds/dt is 1.875 / T and peak d2s/dt2 is 5.7735 / T^2
+            scaling.duration = std::max({min_duration, 1.875f / rate_limit, std::sqrt(5.7735f / accel_limit)});
+            break;
+        case ProfileType::TRAPEZOIDAL:
+            if (rate_limit * rate_limit / accel_limit < 1.0f) {
+                scaling.duration = 1.0f / rate_limit + rate_limit / accel_limit;      // Reaches cruise
+            } else {
+                scaling.duration = 2.0f * std::sqrt(1.0f / accel_limit);              // Triangular
+            }
+            scaling.duration = std::max(min_duration, scaling.duration);
+
+            // Ramp at the acceleration limit for as long as the duration needs: s = a * ta * (T - ta)
+            scaling.accel_time = 0.5f * (scaling.duration -
+                std::sqrt(std::max(0.0f, scaling.duration * scaling.duration - 4.0f / accel_limit)));
+            scaling.peak_rate = 1.0f / (scaling.duration - scaling.accel_time);
+            return scaling;
+        }
+        return scaling;
+    }
+
+    // Fixed duration, e.g. for keyframes with an explicit move time
+    static TimeScaling fixed(ProfileType type, float duration)
+    {
+        return finish(TimeScaling{type, duration, 0.0f, 0.0f});
+    }
+
+    // s(t), clamped to [0, 1]
+    float position(float t) const
+    {
+        if (t >= duration) return 1.0f;     // Also a zero-length move: jump
+        if (t <= 0.0f) return 0.0f;
+
+        float tau = t / duration;
+        switch (type) {
+        case ProfileType::LINEAR:
+            return tau;
+        case ProfileType::MIN_JERK:
+            return tau * tau * tau * (10.0f + tau * (-15.0f + 6.0f * tau));
+        case ProfileType::TRAPEZOIDAL: {
+            float accel = peak_rate / accel_time;
+            if (t < accel_time) {
+                return 0.5f * accel * t * t;
+            }
+            if (t > duration - accel_time) {
+                float remaining = duration - t;
+                return 1.0f - 0.5f * accel * remaining * remaining;
+            }
+            return 0.5f * peak_rate * accel_time + peak_rate * (t - accel_time);
+        }
+        }
+        return 1.0f;
+    }
+
+private:
+    // Without limits a trapezoid spends a quarter of the move on each ramp
+    static TimeScaling finish(TimeScaling scaling)
+    {
+        if (scaling.type == ProfileType::TRAPEZOIDAL && scaling.duration > 0.0f) {
+            scaling.accel_time = scaling.duration / 4.0f;
+            scaling.peak_rate = 1.0f / (scaling.duration - scaling.accel_time);
+        }
+        return scaling;
+    }
+};
+
+#endif  // TRAJECTORY_PROFILE_HPP_
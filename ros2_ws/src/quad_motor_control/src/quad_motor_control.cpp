@@ -1,30 +1,123 @@
 #include "quad_motor_control/quad_motor_control.hpp"
 
 // Control table address for X series (except XL-320)
+#define ADDR_BAUD_RATE 8
+#define ADDR_RETURN_DELAY_TIME 9
+#define ADDR_DRIVE_MODE 10
 #define ADDR_OPERATING_MODE 11
 #define ADDR_TORQUE_ENABLE 64
+#define ADDR_HARDWARE_ERROR_STATUS 70
+#define ADDR_PROFILE_ACCELERATION 108
+#define ADDR_PROFILE_VELOCITY 112
 #define ADDR_GOAL_POSITION 116
+#define ADDR_PRESENT_CURRENT 126
+#define ADDR_PRESENT_VELOCITY 128
 #define ADDR_PRESENT_POSITION 132
+#define ADDR_PRESENT_INPUT_VOLTAGE 144
+#define ADDR_PRESENT_TEMPERATURE 146
+#define ADDR_INDIRECT_ADDRESS_1 168  // 2 bytes per entry, each pointing at one control table byte
+#define ADDR_INDIRECT_DATA_1 224     // Mirrors the bytes listed from ADDR_INDIRECT_ADDRESS_1 on
 
 // Protocol version
 #define PROTOCOL_VERSION 2.0  // Default Protocol version of DYNAMIXEL X series.
 
 // Data Byte Length
 #define LEN_PRESENT_POSITION            4
+#define LEN_PRESENT_CURRENT             2
+#define LEN_PRESENT_VELOCITY            4
+#define LEN_PRESENT_STATE               10  // Present Current + Present Velocity + Present Position
+#define LEN_PRESENT_INPUT_VOLTAGE       2
+#define LEN_PRESENT_TEMPERATURE         1
+#define LEN_HARDWARE_ERROR_STATUS       1
+
+// Motor state gathered into Indirect Data 1.. so one Sync Read returns it all
+#define ADDR_STATE_POSITION             (ADDR_INDIRECT_DATA_1 + 0)
+#define ADDR_STATE_VELOCITY             (ADDR_INDIRECT_DATA_1 + 4)
+#define ADDR_STATE_CURRENT              (ADDR_INDIRECT_DATA_1 + 8)
+#define ADDR_STATE_INPUT_VOLTAGE        (ADDR_INDIRECT_DATA_1 + 10)
+#define ADDR_STATE_TEMPERATURE          (ADDR_INDIRECT_DATA_1 + 12)
+#define ADDR_STATE_HARDWARE_ERROR       (ADDR_INDIRECT_DATA_1 + 13)
+#define LEN_STATE_BLOCK                 14
+#define LEN_PROFILE_AND_GOAL            12  // Profile Acceleration + Profile Velocity + Goal Position
+
+#define DRIVE_MODE_TIME_BASED_PROFILE   0x04
+#define PROFILE_TIME_MAX_MS             32737
 
 // Default setting
 #define BAUDRATE 57600  // Default Baudrate of DYNAMIXEL X series
+#define NUM_BAUD_RATES 8
+#define FACTORY_RETURN_DELAY_US 500
+#define BUS_BUDGET_FRACTION 0.8  // Share of the control period one tick's state read and goal write may use
 #define DEVICE_NAME "/dev/ttyUSB0"  // [Linux]: "/dev/ttyUSB*", [Windows]: "COM*"
 
 #define NUM_MOTORS 12
 #define MOTOR_READ_FAIL -1
 
+// IMU (LSM6-class) registers
+#define IMU_I2C_ADDRESS 0x6A
+#define IMU_REG_CTRL3_C 0x12
+#define IMU_REG_OUTX_L_G 0x22        // Gyro X/Y/Z then accel X/Y/Z, 12 bytes
+#define IMU_CTRL3_C_BDU_IF_INC 0x44  // Block data update + register auto-increment
+#define IMU_ODR_HZ 416               // Output data rate set by CTRL1_XL/CTRL2_G = 0x60
+
+// IMU FIFO (LSM6DSO/LSM6DSR tagged FIFO)
+#define IMU_REG_WHO_AM_I 0x0F
+#define IMU_WHO_AM_I_LSM6DSR 0x6B
+#define IMU_WHO_AM_I_LSM6DSO 0x6C
+#define IMU_REG_FIFO_CTRL1 0x07          // Watermark [7:0], in words
+#define IMU_REG_FIFO_CTRL2 0x08          // Watermark [8]
+#define IMU_REG_FIFO_CTRL3 0x09          // Batch data rate: gyro [7:4], accel [3:0]
+#define IMU_REG_FIFO_CTRL4 0x0A          // FIFO mode [2:0]
+#define IMU_REG_FIFO_STATUS1 0x3A        // Unread words [7:0], FIFO_STATUS2 [1:0] holds [9:8]
+#define IMU_REG_FIFO_DATA_OUT_TAG 0x78   // Tag byte then X/Y/Z, 7 bytes per word
+#define IMU_FIFO_BDR_416HZ 0x66          // Gyro and accel both batched at 416 Hz
+#define IMU_FIFO_MODE_BYPASS 0x00
+#define IMU_FIFO_MODE_CONTINUOUS 0x06
+#define IMU_FIFO_STATUS2_OVR 0x40
+#define IMU_FIFO_TAG_GYRO 0x01
+#define IMU_FIFO_TAG_ACCEL 0x02
+#define IMU_FIFO_WORD_BYTES 7
+#define IMU_FIFO_MAX_SAMPLES 64          // Per drain; a sample is one gyro and one accel word
+#define IMU_GYRO_DPS_PER_LSB (250.0f / 32768.0f)   // 250 dps full scale
+#define IMU_ACCEL_G_PER_LSB (2.0f / 32768.0f)      // +-2 g full scale
+#define IMU_STALE_NS 50000000LL      // Orientation older than this is not used for rolling
+
 // Includes for I2C
 #include <linux/i2c-dev.h>
+#include <linux/i2c.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
 #include <cmath>
+#include <algorithm>
+
+// Includes for the real-time control thread
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <cstring>
+#include <csignal>
+
+#define NSEC_PER_SEC 1000000000LL
+// Default joint limits for time-optimal moves (X series without load is around 45 rpm)
+#define DEFAULT_MAX_VELOCITY_DEG_S 270.0
+#define DEFAULT_MAX_ACCELERATION_DEG_S2 1800.0
+
+// config_id reported for the roll sequences started from the IMU check
+#define ROLL_YELLOW_CONFIG -1
+#define ROLL_BLUE_CONFIG -2
+
+// Set from the SIGUSR1 handler, polled by the executor
+static volatile sig_atomic_t timing_dump_requested = 0;
+
+static void requestTimingDump(int) {
+    timing_dump_requested = 1;
+}
+
+static const char* const LOOP_STAGE_NAMES[static_cast<int>(LoopStage::COUNT)] = {
+    "control_tick", "control_jitter", "bus_write", "bus_read", "imu_read", "publish"
+};
 
 uint8_t dxl_error = 0;
 uint32_t goal_position = 0;
@@ -39,18 +132,140 @@ QuadMotorControl::QuadMotorControl() : Node("quad_motor_control"), last_executed
     int8_t qos_depth = 0;
     this->get_parameter("qos_depth", qos_depth);
 
+    // Serial port of the U2D2; point it at the dxl_simulator pty to run without hardware
+    this->declare_parameter("device_name", std::string(DEVICE_NAME));
+    std::string device_name = DEVICE_NAME;
+    this->get_parameter("device_name", device_name);
+
+    // Bus speed. With baud_autotune the motors are found at whatever rate they use and switched to
+    // baud_rate with return_delay_us (EEPROM, so this only costs time on the first start).
+    // At 1 Mbps a 12-motor state read takes about a tenth of the wire time it takes at 57600.
+    this->declare_parameter("baud_rate", BAUDRATE);
+    this->get_parameter("baud_rate", baud_rate_);
+    this->declare_parameter("baud_autotune", false);
+    this->get_parameter("baud_autotune", baud_autotune_);
+    this->declare_parameter("return_delay_us", 0);
+    this->get_parameter("return_delay_us", return_delay_us_);
+    return_delay_us_ = std::clamp(return_delay_us_, 0, 508);
+
+    // Fast Sync Read returns all motors in a single status packet, but needs recent X series firmware
+    this->declare_parameter("use_fast_sync_read", false);
+    this->get_parameter("use_fast_sync_read", use_fast_sync_read_);
+    // Map position, velocity, current, input voltage, temperature and hardware error into the
+    // indirect data region so they come back contiguously in the one state read per tick.
+    // Dropped at startup when the bus cannot carry the longer read at control_rate_hz.
+    this->declare_parameter("indirect_state_read", true);
+    this->get_parameter("indirect_state_read", indirect_state_);
+
+    // Control thread: loop rate, SCHED_FIFO priority and the CPU to pin it to (-1 = any).
+    // The rate is lowered at startup if one tick takes longer on the bus than the period allows.
+    this->declare_parameter("control_rate_hz", 100);
+    this->get_parameter("control_rate_hz", control_rate_hz_);
+    this->declare_parameter("rt_priority", 80);
+    this->get_parameter("rt_priority", rt_priority_);
+    this->declare_parameter("cpu_affinity", -1);
+    this->get_parameter("cpu_affinity", cpu_affinity_);
+    if (control_rate_hz_ < 100 || control_rate_hz_ > 500) {
+        RCLCPP_WARN(this->get_logger(), "control_rate_hz %d out of range, clamping to 100-500 Hz", control_rate_hz_);
+        control_rate_hz_ = std::clamp(control_rate_hz_, 100, 500);
+    }
+    // /motor_state publishes the newest control thread read at up to this rate
+    this->declare_parameter("motor_state_rate_hz", 50);
+    this->get_parameter("motor_state_rate_hz", motor_state_rate_hz_);
+    motor_state_rate_hz_ = std::clamp(motor_state_rate_hz_, 1, control_rate_hz_);
+    // /loop_timing reports stage latency percentiles over this period (0 = off; SIGUSR1 still logs them)
+    int timing_report_period_ms = 1000;
+    this->declare_parameter("timing_report_period_ms", timing_report_period_ms);
+    this->get_parameter("timing_report_period_ms", timing_report_period_ms);
+
+    // IMU thread: sample rate (the sensor ODR) and its SCHED_FIFO priority, below the control thread
+    this->declare_parameter("imu_rate_hz", IMU_ODR_HZ);
+    this->get_parameter("imu_rate_hz", imu_rate_hz_);
+    this->declare_parameter("imu_rt_priority", 70);
+    this->get_parameter("imu_rt_priority", imu_rt_priority_);
+    if (imu_rate_hz_ < 1 || imu_rate_hz_ > IMU_ODR_HZ) {
+        RCLCPP_WARN(this->get_logger(), "imu_rate_hz %d out of range, clamping to 1-%d Hz", imu_rate_hz_, IMU_ODR_HZ);
+        imu_rate_hz_ = std::clamp(imu_rate_hz_, 1, IMU_ODR_HZ);
+    }
+    // Roll filter gains: the accelerometer corrects the integrated gyro with time constant 1/kp
+    this->declare_parameter("imu_filter_kp", 2.0);
+    this->get_parameter("imu_filter_kp", imu_filter_kp_);
+    this->declare_parameter("imu_filter_ki", 0.1);
+    this->get_parameter("imu_filter_ki", imu_filter_ki_);
+    // Let the IMU batch samples in its FIFO and drain imu_fifo_watermark of them per I2C transaction
+    this->declare_parameter("imu_fifo", true);
+    this->get_parameter("imu_fifo", imu_fifo_enabled_);
+    this->declare_parameter("imu_fifo_watermark", 4);
+    this->get_parameter("imu_fifo_watermark", imu_fifo_watermark_);
+    imu_fifo_watermark_ = std::clamp(imu_fifo_watermark_, 1, 16);   // A batch must stay fresher than IMU_STALE_NS
+
+    // Rolling: start each push early enough that the legs act at the push angle of their side.
+    // Below roll_min_rate_dps (e.g. from rest) the fixed tilt windows are used instead.
+    this->declare_parameter("roll_predictive", true);
+    this->get_parameter("roll_predictive", roll_predictive_);
+    double push_angle_yellow = 0.0, push_angle_blue = 180.0, min_roll_rate = 30.0;
+    int push_latency_ms = 60;
+    this->declare_parameter("roll_push_angle_yellow_deg", push_angle_yellow);
+    this->get_parameter("roll_push_angle_yellow_deg", push_angle_yellow);
+    this->declare_parameter("roll_push_angle_blue_deg", push_angle_blue);
+    this->get_parameter("roll_push_angle_blue_deg", push_angle_blue);
+    this->declare_parameter("roll_push_latency_ms", push_latency_ms);
+    this->get_parameter("roll_push_latency_ms", push_latency_ms);
+    this->declare_parameter("roll_push_hold_ms", 150);
+    this->get_parameter("roll_push_hold_ms", roll_push_hold_ms_);
+    this->declare_parameter("roll_min_rate_dps", min_roll_rate);
+    this->get_parameter("roll_min_rate_dps", min_roll_rate);
+    RollPushScheduler::Params roll_params{};
+    roll_params.yellow_angle_deg = push_angle_yellow;
+    roll_params.blue_angle_deg = push_angle_blue;
+    roll_params.latency_s = push_latency_ms * 1e-3f;
+    roll_params.horizon_s = 0.05f;          // Several roll checks ahead; the control thread keeps the exact delay
+    roll_params.late_tolerance_s = 0.03f;
+    roll_params.min_rate_dps = min_roll_rate;
+    roll_scheduler_ = RollPushScheduler(roll_params);
+
+    // Interpolation of gradual transitions: "min_jerk", "trapezoidal" or "linear",
+    // timed by per-joint limits (index 0 = ID 1) so every joint arrives together
+    this->declare_parameter("motion_profile", std::string("min_jerk"));
+    this->declare_parameter("joint_max_velocity_deg_s", std::vector<double>(NUM_MOTORS, DEFAULT_MAX_VELOCITY_DEG_S));
+    this->declare_parameter("joint_max_acceleration_deg_s2", std::vector<double>(NUM_MOTORS, DEFAULT_MAX_ACCELERATION_DEG_S2));
+    initMotionProfile();
+
+    // Let the servos interpolate configs marked SERVO_PROFILE in position_configs.hpp
+    this->declare_parameter("servo_profile", true);
+    this->get_parameter("servo_profile", servo_profile_enabled_);
+
     const auto QOS_RKL10V =
         rclcpp::QoS(rclcpp::KeepLast(qos_depth)).reliable().durability_volatile();
 
-    this->portHandler = dynamixel::PortHandler::getPortHandler(DEVICE_NAME);
+    this->portHandler = dynamixel::PortHandler::getPortHandler(device_name.c_str());
     this->packetHandler = dynamixel::PacketHandler::getPacketHandler(PROTOCOL_VERSION);
     // Initialize GroupSyncWrite instance
     this->groupSyncWrite = new dynamixel::GroupSyncWrite(portHandler, packetHandler, ADDR_GOAL_POSITION, LEN_PRESENT_POSITION);
-    // Initialize GroupsyncRead instance for Present Position
-    // this->groupSyncRead = new dynamixel::GroupSyncRead(portHandler, packetHandler, ADDR_PRESENT_POSITION, LEN_PRESENT_POSITION);
+    // Profile Acceleration, Profile Velocity and Goal Position are adjacent, so one Sync Write sets a whole servo-side move
+    this->groupProfileWrite = new dynamixel::GroupSyncWrite(portHandler, packetHandler, ADDR_PROFILE_ACCELERATION, LEN_PROFILE_AND_GOAL);
 
     this->initDynamixels();
 
+    // Initialize GroupSyncRead (or GroupFastSyncRead) instance for the motor state.
+    // With the indirect block it covers every field; otherwise Present Current, Velocity and Position.
+    uint16_t state_address = indirect_state_ ? ADDR_INDIRECT_DATA_1 : ADDR_PRESENT_CURRENT;
+    uint16_t state_length = indirect_state_ ? LEN_STATE_BLOCK : LEN_PRESENT_STATE;
+    if (use_fast_sync_read_) {
+        this->groupFastSyncRead = new dynamixel::GroupFastSyncRead(portHandler, packetHandler, state_address, state_length);
+        this->groupSyncRead = this->groupFastSyncRead;
+    } else {
+        this->groupFastSyncRead = nullptr;
+        this->groupSyncRead = new dynamixel::GroupSyncRead(portHandler, packetHandler, state_address, state_length);
+    }
+    for (int id = 1; id <= NUM_MOTORS; id++) {
+        if (!groupSyncRead->addParam(id)) {
+            RCLCPP_WARN(this->get_logger(), "[ID:%03d] SyncRead addParam failed", id);
+        }
+    }
+    RCLCPP_INFO(this->get_logger(), "Reading motor state with %s (%s)", use_fast_sync_read_ ? "Fast Sync Read" : "Sync Read",
+        indirect_state_ ? "indirect block" : "present values only");
+
     // Initialize IMU
     initIMU();
 
@@ -61,28 +276,17 @@ QuadMotorControl::QuadMotorControl() : Node("quad_motor_control"), last_executed
         QOS_RKL10V,
         [this](const SetPosition::SharedPtr msg) -> void
         {
-            uint8_t dxl_error = 0;
-
-            // Position Value of X series is 4 byte data.
-            // For AX & MX(1.0) use 2 byte data(uint16_t) for the Position Value.
-            uint32_t goal_position = (unsigned int)msg->position;  // Convert int32 -> uint32
-
-            // Write Goal Position (length : 4 bytes)
-            // When writing 2 byte data to AX / MX(1.0), use write2ByteTxRx() instead.
-            dxl_comm_result =
-            packetHandler->write4ByteTxRx(
-                portHandler,
-                (uint8_t) msg->id,
-                ADDR_GOAL_POSITION,
-                goal_position,
-                &dxl_error
-            );
-
-            if (dxl_comm_result != COMM_SUCCESS) {
-                RCLCPP_INFO(this->get_logger(), "%s", packetHandler->getTxRxResult(dxl_comm_result));
-            } else if (dxl_error != 0) {
-                RCLCPP_INFO(this->get_logger(), "%s", packetHandler->getRxPacketError(dxl_error));
-            } else {
+            if (msg->id < 1 || msg->id > NUM_MOTORS) {
+                RCLCPP_WARN(this->get_logger(), "Ignoring set_position for unknown [ID: %d]", msg->id);
+                return;
+            }
+
+            // The control thread writes the goal with the next Sync Write
+            MotorCommand command{};
+            command.type = MotorCommand::SET_POSITION;
+            command.id = msg->id;
+            command.position = msg->position;
+            if (enqueueCommand(command)) {
                 RCLCPP_INFO(this->get_logger(), "Set [ID: %d] [Goal Position: %d]", msg->id, msg->position);
             }
         }
@@ -113,7 +317,6 @@ QuadMotorControl::QuadMotorControl() : Node("quad_motor_control"), last_executed
             // Allow turning only if the robot is still in a state before STOPPED_TURNING
             if (config_id == 5 && curr_robot_state_ < RobotStateEnum::STOPPED_TURNING) {
                 RCLCPP_INFO(this->get_logger(), "Robot is still turning, executing config 5.");
-                execute_config(5);
             } else if (config_id == 5 && curr_robot_state_ >= RobotStateEnum::STOPPED_TURNING) {
                 RCLCPP_WARN(this->get_logger(), "Ignoring redundant config 5, robot has already stopped turning.");
                 return;
@@ -124,9 +327,6 @@ QuadMotorControl::QuadMotorControl() : Node("quad_motor_control"), last_executed
 
             RCLCPP_INFO(this->get_logger(), "🔥 Processing latest config update: %d", config_id);
 
-            // Clear any previous queued SyncWrite commands
-            groupSyncWrite->clearParam();
-
             // Execute immediate transformation
             execute_config(config_id);
         }
@@ -138,15 +338,9 @@ QuadMotorControl::QuadMotorControl() : Node("quad_motor_control"), last_executed
         const std::shared_ptr<GetPosition::Request> request,
         std::shared_ptr<GetPosition::Response> response) -> void
         {
-        // Read Present Position (length : 4 bytes) and Convert uint32 -> int32
-        // When reading 2 byte data from AX / MX(1.0), use read2ByteTxRx() instead.
-        dxl_comm_result = packetHandler->read4ByteTxRx(
-            portHandler,
-            (uint8_t) request->id,
-            ADDR_PRESENT_POSITION,
-            reinterpret_cast<uint32_t *>(&present_position),
-            &dxl_error
-        );
+        // Latest Present Position read by the control thread
+        MotorStateSnapshot state = state_snapshot_.load();
+        int present_position = (request->id >= 1 && request->id <= NUM_MOTORS) ? state.present_positions[request->id] : 0;
 
         RCLCPP_INFO(
             this->get_logger(),
@@ -167,17 +361,10 @@ QuadMotorControl::QuadMotorControl() : Node("quad_motor_control"), last_executed
         const std::shared_ptr<GetAllPositions::Request> request,
         std::shared_ptr<GetAllPositions::Response> response) -> void
         {
+            MotorStateSnapshot state = state_snapshot_.load();
+
             for (int id = 1; id <= NUM_MOTORS; id++) {
-                uint32_t motor_position = 0;
-                // Read Present Position (length : 4 bytes) and Convert uint32 -> int32
-                // When reading 2 byte data from AX / MX(1.0), use read2ByteTxRx() instead.
-                dxl_comm_result = packetHandler->read4ByteTxRx(
-                    portHandler,
-                    (uint8_t) id,
-                    ADDR_PRESENT_POSITION,
-                    &motor_position,
-                    &dxl_error
-                );
+                int motor_position = state.present_positions[id];
 
                 RCLCPP_INFO(
                     this->get_logger(),
@@ -204,22 +391,42 @@ QuadMotorControl::QuadMotorControl() : Node("quad_motor_control"), last_executed
         };
 
     get_all_positions_server_ = create_service<GetAllPositions>("get_all_positions", get_all_id_positions);
+    // Kept for existing consumers; /motor_state carries the same positions with more context
     motor_positions_publisher_ = this->create_publisher<quad_interfaces::msg::MotorPositions>("/motor_positions", 10);
 
+    // Position, velocity, current and errors of all motors from one Sync Read
+    motor_state_publisher_ = this->create_publisher<quad_interfaces::msg::MotorState>("/motor_state", 10);
+    motor_state_timer_ = this->create_wall_timer(
+        std::chrono::microseconds(1000000 / motor_state_rate_hz_), [this]() -> void { publishMotorState(); });
+
+    // Per-stage latency percentiles; `kill -USR1 <pid>` logs them since startup
+    if (timing_report_period_ms > 0) {
+        loop_timing_publisher_ = this->create_publisher<quad_interfaces::msg::LoopTiming>("/loop_timing", 10);
+        loop_timing_timer_ = this->create_wall_timer(
+            std::chrono::milliseconds(timing_report_period_ms), [this]() -> void { publishLoopTiming(); });
+    }
+    std::signal(SIGUSR1, requestTimingDump);
+    timing_dump_timer_ = this->create_wall_timer(std::chrono::milliseconds(100), [this]() -> void {
+        if (timing_dump_requested) {
+            timing_dump_requested = 0;
+            logLoopTiming();
+        }
+    });
+
+    // Progress of the running config, published whenever it moves on
+    trajectory_progress_publisher_ = this->create_publisher<quad_interfaces::msg::TrajectoryProgress>("/trajectory_progress", 10);
+    progress_timer_ = this->create_wall_timer(std::chrono::milliseconds(50), [this]() -> void { publishTrajectoryProgress(); });
+
     auto timer_callback =
       [this]() -> void {
+        ScopedLatency probe(stageLatency(LoopStage::PUBLISH));
         auto message = quad_interfaces::msg::MotorPositions();
 
-        // Read motor positions
+        // Latest motor positions read by the control thread
+        MotorStateSnapshot state = state_snapshot_.load();
+
         for (int id = 1; id <= NUM_MOTORS; id++) {
-            uint32_t motor_position = 0;
-            dxl_comm_result = packetHandler->read4ByteTxRx(
-                portHandler,
-                (uint8_t) id,
-                ADDR_PRESENT_POSITION,
-                &motor_position,
-                &dxl_error
-            );
+            int motor_position = state.present_positions[id];
 
             // Assign to message
             switch (id) {
@@ -239,62 +446,63 @@ QuadMotorControl::QuadMotorControl() : Node("quad_motor_control"), last_executed
         }
 
         this->motor_positions_publisher_->publish(message);
-
-        // Check tilt angle if IMU is working
-        if (i2c_file > 0) {
-            float tilt_angle = getTiltAngle();
-            
-            // Only process valid readings
-            if (tilt_angle != -1000.0f) {
-                RCLCPP_DEBUG(this->get_logger(), "Current tilt angle: %.2f degrees", tilt_angle);
-                
-                // Determine orientation based on tilt angle
-                bool blue_under = (tilt_angle >= -180 && tilt_angle <= -122) ||
-                                (tilt_angle >= 123 && tilt_angle <= 180);
-                bool yellow_under = tilt_angle >= -54 && tilt_angle <= 58;
-                
-                // If in ROLLING state and not already moving
-                if (curr_robot_state_ >= RobotStateEnum::ROLLING) {
-                    // Example of how to trigger a roll based on orientation
-                    if (yellow_under) {
-                        RCLCPP_INFO(this->get_logger(), "Yellow side under, initiating yellow push");
-                        // Call yellow push sequence
-                        // For example:
-                        execute_roll_yellow();
-                    } else if (blue_under) {
-                        RCLCPP_INFO(this->get_logger(), "Blue side under, initiating blue push");
-                        // Call blue push sequence
-                        // For example:
-                        execute_roll_blue();
-                    }
-                }
-            }
-        }
       };
     timer_ = this->create_wall_timer(std::chrono::milliseconds(500), timer_callback);
+
+    // Orientation comes from the IMU thread, so the roll check can run much faster than the publisher
+    roll_check_timer_ = this->create_wall_timer(std::chrono::milliseconds(10), [this]() -> void { checkRollOrientation(); });
+
+    // From here on only the control thread talks to the motors and only the IMU thread to the IMU
+    startControlLoop();
+    startImuLoop();
 }
 
 QuadMotorControl::~QuadMotorControl()
 {
+    stopImuLoop();
+    stopControlLoop();
+
+    // GroupSyncRead has no virtual destructor, so delete through the most derived type
+    if (groupFastSyncRead != nullptr) {
+        delete groupFastSyncRead;
+    } else {
+        delete groupSyncRead;
+    }
+    delete groupSyncWrite;
+    delete groupProfileWrite;
+
     if (i2c_file > 0) {
         close(i2c_file);
     }
 }
 
 void QuadMotorControl::execute_roll_yellow() {
-    gradual_transition(yellow_up_cir);
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
-    
-    gradual_transition(perfect_cir);
-    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    enqueueTrajectory(ROLL_YELLOW_CONFIG, {
+        gradual_transition(yellow_up_cir, 500),
+        gradual_transition(perfect_cir, 300)
+    });
 }
 
 void QuadMotorControl::execute_roll_blue() {
-    gradual_transition(blue_up_cir);
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
-    
-    gradual_transition(perfect_cir);
-    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    enqueueTrajectory(ROLL_BLUE_CONFIG, {
+        gradual_transition(blue_up_cir, 500),
+        gradual_transition(perfect_cir, 300)
+    });
+}
+
+void QuadMotorControl::schedule_roll_push(RollSide side, uint32_t delay_ms) {
+    std::vector<Keyframe> keyframes;
+    if (delay_ms > 0) {
+        // Hold the circle until the push is due; the control thread times this against its own clock
+        Keyframe wait{};
+        std::copy(perfect_cir, perfect_cir + NUM_MOTORS + 1, wait.positions);
+        wait.move_ms = 0;
+        wait.hold_ms = delay_ms;
+        keyframes.push_back(wait);
+    }
+    keyframes.push_back(gradual_transition(side == RollSide::YELLOW ? yellow_up_propel : blue_up_propel, roll_push_hold_ms_));
+    keyframes.push_back(gradual_transition(perfect_cir));
+    enqueueTrajectory(side == RollSide::YELLOW ? ROLL_YELLOW_CONFIG : ROLL_BLUE_CONFIG, keyframes);
 }
 
 void QuadMotorControl::execute_config(int config_id) {
@@ -332,60 +540,26 @@ void QuadMotorControl::execute_config(int config_id) {
             break;
     }
     
-    // Use gradual transition for specific transitions
-    if (config_id == 3) {  // Home to Cir - use gradual transition
-        // First get to aligned position
-        gradual_transition(aligned_before_rolling);
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
-        
-        // Then to walk_to_cir1
-        gradual_transition(walk_to_cir1);
-        std::this_thread::sleep_for(std::chrono::milliseconds(300));
-        
-        // Finally to perfect_cir
-        gradual_transition(perfect_cir);
-    }
-    else if (config_id == 4) {  // Cir to Home - use gradual transition
-        // Process each step with gradual transition
-        gradual_transition(perfect_cir);
-        std::this_thread::sleep_for(std::chrono::milliseconds(700));
-        
-        gradual_transition(cir_to_blue3_180);
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-        
-        // Continue with each step...
-        gradual_transition(cir_to_both_blues_180);
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-        
-        gradual_transition(cir_to_yellow_up60);
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-        
-        gradual_transition(cir_to_yellow_up90);
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-        
-        gradual_transition(aligned_before_rolling);
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-        
-        gradual_transition(home_tiptoe_thin);
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-        
-        gradual_transition(home_tiptoe);
-    }
-    else {
-        // For other configs, use the original method
-        for (size_t i = 0; i < config_sequence.size(); i++) {
-            apply_motor_positions(config_sequence[i]);
-            
-            if (i < sleep_durations.size()) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(sleep_durations[i]));
-            }
+    // Build the keyframes; the control thread runs them and a newer config preempts them
+    std::vector<Keyframe> keyframes;
+    for (size_t i = 0; i < config_sequence.size(); i++) {
+        int hold_ms = (i < sleep_durations.size()) ? sleep_durations[i] : 0;
+
+        if (config_id == 3 || config_id == 4) {  // Home to Cir / Cir to Home - use gradual transition
+            keyframes.push_back(gradual_transition(config_sequence[i], hold_ms));
+        } else {
+            Keyframe keyframe{};
+            std::copy(config_sequence[i], config_sequence[i] + NUM_MOTORS + 1, keyframe.positions);
+            keyframe.move_ms = 0;
+            keyframe.hold_ms = hold_ms;
+            keyframes.push_back(keyframe);
         }
     }
+    enqueueTrajectory(config_id, keyframes);
 }
 
 void QuadMotorControl::apply_motor_positions(int* target_positions) {
-    groupSyncWrite->clearParam();
-    
+    // The 12 IDs stay listed in groupSyncWrite; only the goal positions are overwritten in place
     for (int id = 1; id <= NUM_MOTORS; id++) {
         uint8_t param_goal_position[4];
         int goal_position = target_positions[id];
@@ -395,18 +569,251 @@ void QuadMotorControl::apply_motor_positions(int* target_positions) {
         param_goal_position[2] = DXL_LOBYTE(DXL_HIWORD(goal_position));
         param_goal_position[3] = DXL_HIBYTE(DXL_HIWORD(goal_position));
 
-        if (!groupSyncWrite->addParam(id, param_goal_position)) {
+        if (!groupSyncWrite->changeParam(id, param_goal_position) &&
+            !groupSyncWrite->addParam(id, param_goal_position)) {
             RCLCPP_WARN(this->get_logger(), "[ID:%03d] SyncWrite addParam failed", id);
         }
     }
 
     // **Transmit transformation immediately**
-    int dxl_comm_result = groupSyncWrite->txPacket();
+    int dxl_comm_result;
+    {
+        ScopedLatency probe(stageLatency(LoopStage::BUS_WRITE));
+        dxl_comm_result = groupSyncWrite->txPacket();
+    }
     if (dxl_comm_result != COMM_SUCCESS) {
         RCLCPP_ERROR(this->get_logger(), "SyncWrite Failed: %s", packetHandler->getTxRxResult(dxl_comm_result));
     }
+}
+
+void QuadMotorControl::apply_servo_profile_move(int* target_positions, uint32_t accel_ms, uint32_t duration_ms) {
+    // In time-based mode the servos ramp for accel_ms and arrive after duration_ms; 0 / 0 means move at once
+    uint32_t profile_acceleration = std::min<uint32_t>(accel_ms, PROFILE_TIME_MAX_MS);
+    uint32_t profile_velocity = std::min<uint32_t>(duration_ms, PROFILE_TIME_MAX_MS);
+
+    for (int id = 1; id <= NUM_MOTORS; id++) {
+        uint8_t param[LEN_PROFILE_AND_GOAL];
+        uint32_t values[3] = {profile_acceleration, profile_velocity, (uint32_t)target_positions[id]};
+
+        for (int i = 0; i < 3; i++) {
+            param[i * 4 + 0] = DXL_LOBYTE(DXL_LOWORD(values[i]));
+            param[i * 4 + 1] = DXL_HIBYTE(DXL_LOWORD(values[i]));
+            param[i * 4 + 2] = DXL_LOBYTE(DXL_HIWORD(values[i]));
+            param[i * 4 + 3] = DXL_HIBYTE(DXL_HIWORD(values[i]));
+        }
+
+        if (!groupProfileWrite->changeParam(id, param) &&
+            !groupProfileWrite->addParam(id, param)) {
+            RCLCPP_WARN(this->get_logger(), "[ID:%03d] Profile SyncWrite addParam failed", id);
+        }
+    }
+
+    int dxl_comm_result;
+    {
+        ScopedLatency probe(stageLatency(LoopStage::BUS_WRITE));
+        dxl_comm_result = groupProfileWrite->txPacket();
+    }
+    if (dxl_comm_result != COMM_SUCCESS) {
+        RCLCPP_ERROR(this->get_logger(), "Profile SyncWrite Failed: %s", packetHandler->getTxRxResult(dxl_comm_result));
+        return;
+    }
+    servo_profile_active_ = (profile_velocity != 0);
+}
+
+bool QuadMotorControl::configureIndirectState() {
+    // Control table fields in the order they appear in the indirect data block
+    static const uint16_t fields[][2] = {
+        {ADDR_PRESENT_POSITION, LEN_PRESENT_POSITION},
+        {ADDR_PRESENT_VELOCITY, LEN_PRESENT_VELOCITY},
+        {ADDR_PRESENT_CURRENT, LEN_PRESENT_CURRENT},
+        {ADDR_PRESENT_INPUT_VOLTAGE, LEN_PRESENT_INPUT_VOLTAGE},
+        {ADDR_PRESENT_TEMPERATURE, LEN_PRESENT_TEMPERATURE},
+        {ADDR_HARDWARE_ERROR_STATUS, LEN_HARDWARE_ERROR_STATUS}
+    };
+
+    uint8_t indirect_addresses[LEN_STATE_BLOCK * 2];
+    int entry = 0;
+    for (const auto& field : fields) {
+        for (uint16_t byte = 0; byte < field[1]; byte++) {
+            indirect_addresses[entry * 2] = DXL_LOBYTE(field[0] + byte);
+            indirect_addresses[entry * 2 + 1] = DXL_HIBYTE(field[0] + byte);
+            entry++;
+        }
+    }
 
-    groupSyncWrite->clearParam(); // Clear after sending
+    // Same mapping for every motor: one Sync Write, then read it back since Sync Write has no status.
+    // Needs torque off, which initDynamixels has already done.
+    dynamixel::GroupSyncWrite indirectWrite(portHandler, packetHandler, ADDR_INDIRECT_ADDRESS_1, sizeof(indirect_addresses));
+    for (int id = 1; id <= NUM_MOTORS; id++) {
+        indirectWrite.addParam(id, indirect_addresses);
+    }
+    dxl_comm_result = indirectWrite.txPacket();
+    if (dxl_comm_result != COMM_SUCCESS) {
+        RCLCPP_WARN(this->get_logger(), "Failed to write indirect addresses: %s", packetHandler->getTxRxResult(dxl_comm_result));
+        return false;
+    }
+    for (int id = 1; id <= NUM_MOTORS; id++) {
+        uint8_t readback[sizeof(indirect_addresses)];
+        dxl_comm_result = packetHandler->readTxRx(portHandler, id, ADDR_INDIRECT_ADDRESS_1, sizeof(readback), readback, &dxl_error);
+        if (dxl_comm_result != COMM_SUCCESS || dxl_error != 0 || memcmp(readback, indirect_addresses, sizeof(readback)) != 0) {
+            RCLCPP_ERROR(this->get_logger(), "[ID:%03d] Indirect addresses not set", id);
+            return false;
+        }
+    }
+    RCLCPP_INFO(this->get_logger(), "Indirect state block configured on all motors.");
+    return true;
+}
+
+bool QuadMotorControl::configureBus() {
+    // Baud Rate register value -> bits per second, and the order to look for motors in
+    static const int baud_rates[NUM_BAUD_RATES] = {9600, 57600, 115200, 1000000, 2000000, 3000000, 4000000, 4500000};
+    static const int scan_order[NUM_BAUD_RATES] = {57600, 1000000, 4000000, 2000000, 3000000, 115200, 4500000, 9600};
+    const int baud_index = std::find(baud_rates, baud_rates + NUM_BAUD_RATES, baud_rate_) - baud_rates;
+    const uint8_t return_delay = (uint8_t)(return_delay_us_ / 2);
+    if (baud_index == NUM_BAUD_RATES) {
+        RCLCPP_ERROR(this->get_logger(), "baud_rate %d is not an X series rate", baud_rate_);
+        return false;
+    }
+
+    bool found[NUM_MOTORS + 1] = {false};
+    for (int scan = -1; scan < NUM_BAUD_RATES; scan++) {
+        // First the target rate, then every other rate for motors still missing
+        int baud_rate = (scan < 0) ? baud_rate_ : scan_order[scan];
+        if ((scan >= 0 && baud_rate == baud_rate_) || !portHandler->setBaudRate(baud_rate)) {
+            continue;
+        }
+
+        std::vector<uint8_t> ids;
+        packetHandler->broadcastPing(portHandler, ids);
+        for (uint8_t id : ids) {
+            if (id < 1 || id > NUM_MOTORS || found[id]) {
+                continue;
+            }
+            found[id] = true;
+
+            // Both registers are EEPROM: torque off first, and only write what differs
+            uint8_t current_delay = 0;
+            if (packetHandler->read1ByteTxRx(portHandler, id, ADDR_RETURN_DELAY_TIME, &current_delay, &dxl_error) == COMM_SUCCESS &&
+                current_delay == return_delay && baud_rate == baud_rate_) {
+                continue;
+            }
+            dxl_comm_result = packetHandler->write1ByteTxRx(portHandler, id, ADDR_TORQUE_ENABLE, 0, &dxl_error);
+            if (dxl_comm_result != COMM_SUCCESS || dxl_error != 0) {
+                RCLCPP_ERROR(this->get_logger(), "[ID:%03d] Torque off failed at %d bps: %s", id, baud_rate,
+                    dxl_comm_result != COMM_SUCCESS ? packetHandler->getTxRxResult(dxl_comm_result) : packetHandler->getRxPacketError(dxl_error));
+                continue;
+            }
+            dxl_comm_result = packetHandler->write1ByteTxRx(portHandler, id, ADDR_RETURN_DELAY_TIME, return_delay, &dxl_error);
+            if (dxl_comm_result != COMM_SUCCESS || dxl_error != 0) {
+                RCLCPP_ERROR(this->get_logger(), "[ID:%03d] Return Delay Time write failed at %d bps: %s", id, baud_rate,
+                    dxl_comm_result != COMM_SUCCESS ? packetHandler->getTxRxResult(dxl_comm_result) : packetHandler->getRxPacketError(dxl_error));
+                continue;
+            }
+            if (baud_rate != baud_rate_) {
+                // The reply may already be lost to the switch; the check below decides
+                packetHandler->write1ByteTxRx(portHandler, id, ADDR_BAUD_RATE, baud_index, &dxl_error);
+                RCLCPP_INFO(this->get_logger(), "[ID:%03d] Moved from %d to %d bps", id, baud_rate, baud_rate_);
+            }
+        }
+        if (std::count(found + 1, found + NUM_MOTORS + 1, true) == NUM_MOTORS) {
+            break;
+        }
+    }
+
+    // Verify at the target rate
+    portHandler->setBaudRate(baud_rate_);
+    bool all_ok = true;
+    for (int id = 1; id <= NUM_MOTORS; id++) {
+        uint8_t value = 0xFF;
+        dxl_comm_result = packetHandler->read1ByteTxRx(portHandler, id, ADDR_RETURN_DELAY_TIME, &value, &dxl_error);
+        if (dxl_comm_result != COMM_SUCCESS || value != return_delay) {
+            RCLCPP_ERROR(this->get_logger(), "[ID:%03d] Not configured: %s", id,
+                dxl_comm_result != COMM_SUCCESS ? packetHandler->getTxRxResult(dxl_comm_result) : "Return Delay Time did not change");
+            all_ok = false;
+        }
+    }
+    if (all_ok) {
+        RCLCPP_INFO(this->get_logger(), "All motors at %d bps, return delay %d us", baud_rate_, return_delay * 2);
+    }
+    return all_ok;
+}
+
+// Wire time of one control tick: the state read of every motor and a Goal Position Sync Write.
+// Protocol 2.0 framing at 10 bits per byte. Every status packet of a Sync Read waits out the
+// Return Delay Time; the single packet of a Fast Sync Read waits once.
+double QuadMotorControl::tickBusTime(int read_length, int return_delay_us) const {
+    const int read_instruction = 14 + NUM_MOTORS;                               // One ID per motor
+    const int goal_write = 14 + NUM_MOTORS * (1 + LEN_PRESENT_POSITION);
+    int status_bytes = NUM_MOTORS * (11 + read_length);
+    int return_delays = NUM_MOTORS;
+    if (use_fast_sync_read_) {
+        status_bytes = 8 + NUM_MOTORS * (4 + read_length);                      // Error, ID, data and CRC per motor
+        return_delays = 1;
+    }
+    return (read_instruction + status_bytes + goal_write) * 10.0 / baud_rate_ + return_delays * return_delay_us * 1e-6;
+}
+
+// At the factory 57600 bps and 500 us Return Delay Time a 12-motor tick takes tens of ms, far
+// over a 10 ms period. Check that before the control thread starts instead of leaving it to the
+// overrun counter: drop the indirect block first, then lower the rate to what the bus carries.
+void QuadMotorControl::fitControlRateToBus() {
+    int return_delay_us = -1;
+    for (int id = 1; id <= NUM_MOTORS; id++) {
+        uint8_t value = 0;
+        if (packetHandler->read1ByteTxRx(portHandler, id, ADDR_RETURN_DELAY_TIME, &value, &dxl_error) == COMM_SUCCESS) {
+            return_delay_us = std::max(return_delay_us, value * 2);
+        }
+    }
+    if (return_delay_us < 0) {
+        return_delay_us = FACTORY_RETURN_DELAY_US;  // Nothing answered; assume the worst common case
+    }
+
+    const double budget = BUS_BUDGET_FRACTION / control_rate_hz_;
+    if (indirect_state_ && tickBusTime(LEN_STATE_BLOCK, return_delay_us) > budget) {
+        indirect_state_ = false;
+        RCLCPP_WARN(this->get_logger(), "Indirect state block does not fit %d Hz at %d bps, reading present values only.",
+            control_rate_hz_, baud_rate_);
+    }
+
+    double tick = tickBusTime(indirect_state_ ? LEN_STATE_BLOCK : LEN_PRESENT_STATE, return_delay_us);
+    if (tick > budget) {
+        int rate_hz = std::max(1, (int)(BUS_BUDGET_FRACTION / tick));
+        RCLCPP_ERROR(this->get_logger(),
+            "A control tick needs %.1f ms on the bus at %d bps with a %d us return delay; lowering control_rate_hz "
+            "from %d to %d Hz. Set baud_autotune with baud_rate 1000000 to keep the requested rate.",
+            tick * 1e3, baud_rate_, return_delay_us, control_rate_hz_, rate_hz);
+        control_rate_hz_ = rate_hz;
+        motor_state_rate_hz_ = std::min(motor_state_rate_hz_, control_rate_hz_);
+    } else {
+        RCLCPP_INFO(this->get_logger(), "A control tick needs %.1f ms on the bus, %.1f ms period", tick * 1e3,
+            1e3 / control_rate_hz_);
+    }
+}
+
+bool QuadMotorControl::enableTimeBasedProfile() {
+    // Drive Mode is writable only with torque off (initDynamixels turns it off first).
+    // Read-modify-write to keep the direction bit of each servo.
+    for (int id = 1; id <= NUM_MOTORS; id++) {
+        uint8_t drive_mode = 0;
+        dxl_comm_result = packetHandler->read1ByteTxRx(portHandler, id, ADDR_DRIVE_MODE, &drive_mode, &dxl_error);
+        if (dxl_comm_result != COMM_SUCCESS || dxl_error != 0) {
+            RCLCPP_WARN(this->get_logger(), "[ID:%03d] Failed to read Drive Mode", id);
+            return false;
+        }
+        if (drive_mode & DRIVE_MODE_TIME_BASED_PROFILE) {
+            continue;
+        }
+
+        dxl_comm_result = packetHandler->write1ByteTxRx(portHandler, id, ADDR_DRIVE_MODE,
+            drive_mode | DRIVE_MODE_TIME_BASED_PROFILE, &dxl_error);
+        if (dxl_comm_result != COMM_SUCCESS || dxl_error != 0) {
+            RCLCPP_ERROR(this->get_logger(), "[ID:%03d] Drive Mode write rejected: %s", id,
+                dxl_comm_result != COMM_SUCCESS ? packetHandler->getTxRxResult(dxl_comm_result) : packetHandler->getRxPacketError(dxl_error));
+            return false;
+        }
+    }
+    RCLCPP_INFO(this->get_logger(), "Time-based profile enabled on all motors.");
+    return true;
 }
 
 
@@ -421,13 +828,33 @@ void QuadMotorControl::initDynamixels()
     }
 
     // Set the baudrate of the serial port (use DYNAMIXEL Baudrate)
-    dxl_comm_result = portHandler->setBaudRate(BAUDRATE);
+    dxl_comm_result = portHandler->setBaudRate(baud_rate_);
     if (dxl_comm_result == false) {
         RCLCPP_ERROR(rclcpp::get_logger("read_write_node"), "Failed to set the baudrate!");
     } else {
         RCLCPP_INFO(rclcpp::get_logger("read_write_node"), "Succeeded to set the baudrate.");
     }
 
+    if (baud_autotune_ && !configureBus()) {
+        RCLCPP_ERROR(rclcpp::get_logger("quad_motor_control"), "Not all motors answer at %d bps.", baud_rate_);
+    }
+
+    // Settles indirect_state_ before the indirect block is configured below
+    fitControlRateToBus();
+
+    // Operating Mode, Drive Mode and the indirect addresses are writable only with torque off,
+    // and a previous run may have left it on
+    dxl_comm_result = packetHandler->write1ByteTxRx(
+        this->portHandler,
+        BROADCAST_ID,
+        ADDR_TORQUE_ENABLE,
+        0,
+        &dxl_error
+    );
+    if (dxl_comm_result != COMM_SUCCESS) {
+        RCLCPP_ERROR(rclcpp::get_logger("quad_motor_control"), "Failed to disable torque.");
+    }
+
     // Use Position Control Mode
     dxl_comm_result = packetHandler->write1ByteTxRx(
         this->portHandler,
@@ -443,6 +870,22 @@ void QuadMotorControl::initDynamixels()
     RCLCPP_INFO(rclcpp::get_logger("quad_motor_control"), "Succeeded to set Position Control Mode.");
   }
 
+  // Time-based profiles: Profile Velocity/Acceleration become move/ramp times in ms
+  if (servo_profile_enabled_) {
+    servo_profile_enabled_ = enableTimeBasedProfile();
+    if (!servo_profile_enabled_) {
+      RCLCPP_WARN(rclcpp::get_logger("quad_motor_control"), "Time-based profile unavailable, interpolating every config on the host.");
+    }
+  }
+
+  // Indirect addresses are writable only with torque off too
+  if (indirect_state_) {
+    indirect_state_ = configureIndirectState();
+    if (!indirect_state_) {
+      RCLCPP_WARN(rclcpp::get_logger("quad_motor_control"), "Indirect state block unavailable, reading present values only.");
+    }
+  }
+
   // Enable Torque of DYNAMIXEL
   dxl_comm_result = packetHandler->write1ByteTxRx(
     this->portHandler,
@@ -471,7 +914,7 @@ void QuadMotorControl::initIMU() {
     }
 
     // Set I2C device address (LSM330DHCX)
-    int addr = 0x6A;
+    int addr = IMU_I2C_ADDRESS;
     if (ioctl(i2c_file, I2C_SLAVE, addr) < 0) {
         RCLCPP_ERROR(this->get_logger(), "Failed to set I2C address");
         close(i2c_file);
@@ -482,12 +925,15 @@ void QuadMotorControl::initIMU() {
     // Enable gyroscope and accelerometer
     write_register(0x10, 0x60);  // Accelerometer
     write_register(0x11, 0x60);  // Gyroscope
-    
-    // Initialize IMU variables
-    accumulated_tilt_angle = 0.0f;
-    sample_count = 0;
-    
-    RCLCPP_INFO(this->get_logger(), "IMU initialized successfully");
+    write_register(IMU_REG_CTRL3_C, IMU_CTRL3_C_BDU_IF_INC);  // Consistent burst reads
+
+    imu_fifo_active_ = imu_fifo_enabled_ && configureImuFifo();
+    if (!imu_fifo_active_) {
+        write_register(IMU_REG_FIFO_CTRL4, IMU_FIFO_MODE_BYPASS);
+    }
+
+    RCLCPP_INFO(this->get_logger(), "IMU initialized successfully (%s)",
+        imu_fifo_active_ ? "FIFO batches" : "polled samples");
     
     // Sleep to allow sensor to initialize
     std::this_thread::sleep_for(std::chrono::milliseconds(1000));
@@ -515,93 +961,599 @@ int QuadMotorControl::read_register(uint8_t reg) {
     return data;
 }
 
-int16_t QuadMotorControl::read_16bit_register(uint8_t reg_low, uint8_t reg_high) {
-    int16_t low = read_register(reg_low);
-    int16_t high = read_register(reg_high);
-    if (low == -1 || high == -1) return -1;
-    return (high << 8) | low;
+int QuadMotorControl::readImuRegisters(uint8_t reg, uint8_t* data, uint16_t length) {
+    // Register address write + repeated-start read in one I2C_RDWR transaction
+    struct i2c_msg msgs[2];
+    msgs[0].addr = IMU_I2C_ADDRESS;
+    msgs[0].flags = 0;
+    msgs[0].len = 1;
+    msgs[0].buf = &reg;
+    msgs[1].addr = IMU_I2C_ADDRESS;
+    msgs[1].flags = I2C_M_RD;
+    msgs[1].len = length;
+    msgs[1].buf = data;
+
+    struct i2c_rdwr_ioctl_data transfer;
+    transfer.msgs = msgs;
+    transfer.nmsgs = 2;
+    if (ioctl(i2c_file, I2C_RDWR, &transfer) != 2) {
+        return -1;
+    }
+    return 0;
 }
 
-float QuadMotorControl::getTiltAngle() {
-    // Read accelerometer data
-    // int16_t accel_x = read_16bit_register(0x28, 0x29);
-    int16_t accel_y = read_16bit_register(0x2A, 0x2B);
-    int16_t accel_z = read_16bit_register(0x2C, 0x2D);
-    
-    // Apply scale factors and bias correction
-    float accel_z_offset = 0.2;
-    // float accel_mps2_x = accel_x * (2.0 / 32768.0) * 9.81;
-    float accel_mps2_y = accel_y * (2.0 / 32768.0) * 9.81;
-    float accel_mps2_z = ((accel_z * (2.0 / 32768.0)) * 9.81) - accel_z_offset;
-    
-    // Compute tilt angle around x-axis
-    float angle_rad = std::atan2(accel_mps2_y, accel_mps2_z);
-    float angle_degrees = angle_rad * (180.0 / M_PI);
-    
-    // Add to accumulated values for averaging
-    accumulated_tilt_angle += angle_degrees;
-    sample_count++;
-    
-    // If we have enough samples, return the average
-    if (sample_count >= window_size) {
-        float avg_tilt_angle = accumulated_tilt_angle / sample_count;
-        
-        // Reset for next reading
-        accumulated_tilt_angle = 0;
-        sample_count = 0;
-        
-        return avg_tilt_angle;
+int QuadMotorControl::readImuSample(ImuSample* sample) {
+    uint8_t data[12];
+    if (readImuRegisters(IMU_REG_OUTX_L_G, data, sizeof(data)) != 0) {
+        RCLCPP_ERROR_THROTTLE(this->get_logger(), *this->get_clock(), 1000, "Failed to read IMU sample");
+        return -1;
     }
-    
-    // Not enough samples yet
-    return -1000.0f;  // Special value indicating not ready
+
+    sample->gyro_x = (int16_t)(data[1] << 8 | data[0]);
+    sample->gyro_y = (int16_t)(data[3] << 8 | data[2]);
+    sample->gyro_z = (int16_t)(data[5] << 8 | data[4]);
+    sample->accel_x = (int16_t)(data[7] << 8 | data[6]);
+    sample->accel_y = (int16_t)(data[9] << 8 | data[8]);
+    sample->accel_z = (int16_t)(data[11] << 8 | data[10]);
+    return 0;
 }
 
-void QuadMotorControl::update_present_positions() {
+bool QuadMotorControl::configureImuFifo() {
+    // Only the tagged FIFO of the LSM6DSO/LSM6DSR is supported; others keep polling
+    int who_am_i = read_register(IMU_REG_WHO_AM_I);
+    if (who_am_i != IMU_WHO_AM_I_LSM6DSO && who_am_i != IMU_WHO_AM_I_LSM6DSR) {
+        RCLCPP_WARN(this->get_logger(), "IMU WHO_AM_I 0x%02x has no tagged FIFO, polling samples instead", who_am_i);
+        return false;
+    }
+
+    // Continuous mode: the oldest words are overwritten if we fall behind, never blocking the sensor
+    int watermark_words = imu_fifo_watermark_ * 2;
+    if (write_register(IMU_REG_FIFO_CTRL4, IMU_FIFO_MODE_BYPASS) != 0 ||        // Also empties the FIFO
+        write_register(IMU_REG_FIFO_CTRL1, watermark_words & 0xFF) != 0 ||
+        write_register(IMU_REG_FIFO_CTRL2, (watermark_words >> 8) & 0x01) != 0 ||
+        write_register(IMU_REG_FIFO_CTRL3, IMU_FIFO_BDR_416HZ) != 0 ||
+        write_register(IMU_REG_FIFO_CTRL4, IMU_FIFO_MODE_CONTINUOUS) != 0) {
+        return false;
+    }
+    return true;
+}
+
+int QuadMotorControl::drainImuFifo(ImuSample* samples, int max_samples) {
+    uint8_t status[2];
+    if (readImuRegisters(IMU_REG_FIFO_STATUS1, status, sizeof(status)) != 0) {
+        RCLCPP_ERROR_THROTTLE(this->get_logger(), *this->get_clock(), 1000, "Failed to read IMU FIFO status");
+        return -1;
+    }
+    if (status[1] & IMU_FIFO_STATUS2_OVR) {
+        RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 1000, "IMU FIFO overrun, samples were lost");
+    }
+    int words = std::min((status[1] & 0x03) << 8 | status[0], max_samples * 2);
+    if (words == 0) {
+        return 0;
+    }
+
+    // Burst reads of FIFO_DATA_OUT roll over from 0x7E back to the tag at 0x78, so all words come in one transaction
+    uint8_t data[IMU_FIFO_MAX_SAMPLES * 2 * IMU_FIFO_WORD_BYTES];
+    if (readImuRegisters(IMU_REG_FIFO_DATA_OUT_TAG, data, words * IMU_FIFO_WORD_BYTES) != 0) {
+        RCLCPP_ERROR_THROTTLE(this->get_logger(), *this->get_clock(), 1000, "Failed to read IMU FIFO");
+        return -1;
+    }
+
+    // Each accel word completes a sample with the most recent gyro word
+    int count = 0;
+    ImuSample& pending = imu_fifo_pending_;     // A gyro word may arrive in one batch and its accel in the next
+    for (int w = 0; w < words; w++) {
+        const uint8_t* word = &data[w * IMU_FIFO_WORD_BYTES];
+        int16_t x = (int16_t)(word[2] << 8 | word[1]);
+        int16_t y = (int16_t)(word[4] << 8 | word[3]);
+        int16_t z = (int16_t)(word[6] << 8 | word[5]);
+        switch (word[0] >> 3) {
+        case IMU_FIFO_TAG_GYRO:
+            pending.gyro_x = x;
+            pending.gyro_y = y;
+            pending.gyro_z = z;
+            break;
+        case IMU_FIFO_TAG_ACCEL:
+            pending.accel_x = x;
+            pending.accel_y = y;
+            pending.accel_z = z;
+            samples[count++] = pending;
+            break;
+        default:
+            break;  // Timestamp or sensor hub words are not enabled
+        }
+    }
+    return count;
+}
+
+bool QuadMotorControl::getLatestImuReading(ImuReading* reading) const {
+    return imu_ring_.latest(reading);
+}
+
+void QuadMotorControl::checkRollOrientation() {
+    ImuReading reading;
+    if (!getLatestImuReading(&reading)) {
+        return;  // IMU not working or no sample yet
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (now.tv_sec * NSEC_PER_SEC + now.tv_nsec - reading.stamp_ns > IMU_STALE_NS) {
+        RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 1000, "IMU orientation is stale, not checking roll");
+        return;
+    }
+
+    // Extrapolate to now; the reading can be a FIFO batch old
+    int64_t age_ns = now.tv_sec * NSEC_PER_SEC + now.tv_nsec - reading.stamp_ns;
+    float tilt_angle = wrapDegrees(reading.tilt_deg + reading.roll_rate_dps * age_ns * 1e-9f);
+    RCLCPP_DEBUG(this->get_logger(), "Current tilt angle: %.2f degrees, rate %.1f deg/s", tilt_angle, reading.roll_rate_dps);
+
+    if (curr_robot_state_ < RobotStateEnum::ROLLING || !isMotionIdle()) {
+        return;
+    }
+
+    // Moving: push ahead of time so the legs act at the push angle instead of after it
+    float delay_s;
+    RollSide side = roll_predictive_ ? roll_scheduler_.update(tilt_angle, reading.roll_rate_dps, &delay_s) : RollSide::NONE;
+    if (side != RollSide::NONE) {
+        RCLCPP_INFO(this->get_logger(), "%s push in %.0f ms (tilt %.1f degrees, %.0f deg/s)",
+            side == RollSide::YELLOW ? "Yellow" : "Blue", delay_s * 1000.0f, tilt_angle, reading.roll_rate_dps);
+        schedule_roll_push(side, (uint32_t)std::lround(delay_s * 1000.0f));
+        return;
+    }
+    if (roll_predictive_ && std::fabs(reading.roll_rate_dps) >= roll_scheduler_.minRateDps()) {
+        return;  // Rolling: wait for the predicted push
+    }
+
+    // Determine orientation based on tilt angle; the blue range wraps through 180
+    bool blue_under = angleInRange(tilt_angle, 123, -122);
+    bool yellow_under = angleInRange(tilt_angle, -54, 58);
+
+    // Too slow to predict (e.g. at rest): push whichever side is under now
+    if (yellow_under) {
+        RCLCPP_INFO(this->get_logger(), "Yellow side under, initiating yellow push");
+        roll_scheduler_.markPushed(RollSide::YELLOW);
+        execute_roll_yellow();
+    } else if (blue_under) {
+        RCLCPP_INFO(this->get_logger(), "Blue side under, initiating blue push");
+        roll_scheduler_.markPushed(RollSide::BLUE);
+        execute_roll_blue();
+    }
+}
+
+int QuadMotorControl::readMotorState(MotorStateSnapshot* state) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // txRxPacket is not virtual, so call it on the type that was constructed
+    if (groupFastSyncRead != nullptr) {
+        dxl_comm_result = groupFastSyncRead->txRxPacket();
+    } else {
+        dxl_comm_result = groupSyncRead->txRxPacket();
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    state->read_stamp_ns = end.tv_sec * NSEC_PER_SEC + end.tv_nsec;
+    state->read_latency_ns = state->read_stamp_ns - (start.tv_sec * NSEC_PER_SEC + start.tv_nsec);
+    stageLatency(LoopStage::BUS_READ).record(state->read_latency_ns);
+
+    if (dxl_comm_result != COMM_SUCCESS) {
+        RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 1000,
+            "SyncRead Failed: %s", packetHandler->getTxRxResult(dxl_comm_result));
+        return dxl_comm_result;
+    }
+
+    // Decode each field into its array; motors that did not answer keep their previous values
     for (int id = 1; id <= NUM_MOTORS; id++) {
-        uint32_t motor_position = 0;
-        dxl_comm_result = packetHandler->read4ByteTxRx(
-            portHandler,
-            (uint8_t) id,
-            ADDR_PRESENT_POSITION,
-            &motor_position,
-            &dxl_error
-        );
-        
-        if (dxl_comm_result == COMM_SUCCESS) {
-            present_positions[id] = motor_position;
+        if (indirect_state_) {
+            if (!groupSyncRead->isAvailable(id, ADDR_INDIRECT_DATA_1, LEN_STATE_BLOCK)) {
+                continue;
+            }
+            state->present_positions[id] = (int32_t)groupSyncRead->getData(id, ADDR_STATE_POSITION, LEN_PRESENT_POSITION);
+            state->present_velocities[id] = (int32_t)groupSyncRead->getData(id, ADDR_STATE_VELOCITY, LEN_PRESENT_VELOCITY);
+            state->present_currents[id] = (int16_t)groupSyncRead->getData(id, ADDR_STATE_CURRENT, LEN_PRESENT_CURRENT);
+            state->input_voltages[id] = (uint16_t)groupSyncRead->getData(id, ADDR_STATE_INPUT_VOLTAGE, LEN_PRESENT_INPUT_VOLTAGE);
+            state->temperatures[id] = (uint8_t)groupSyncRead->getData(id, ADDR_STATE_TEMPERATURE, LEN_PRESENT_TEMPERATURE);
+            state->hardware_errors[id] = (uint8_t)groupSyncRead->getData(id, ADDR_STATE_HARDWARE_ERROR, LEN_HARDWARE_ERROR_STATUS);
+        } else {
+            if (!groupSyncRead->isAvailable(id, ADDR_PRESENT_CURRENT, LEN_PRESENT_STATE)) {
+                continue;
+            }
+            state->present_currents[id] = (int16_t)groupSyncRead->getData(id, ADDR_PRESENT_CURRENT, LEN_PRESENT_CURRENT);
+            state->present_velocities[id] = (int32_t)groupSyncRead->getData(id, ADDR_PRESENT_VELOCITY, LEN_PRESENT_VELOCITY);
+            state->present_positions[id] = (int32_t)groupSyncRead->getData(id, ADDR_PRESENT_POSITION, LEN_PRESENT_POSITION);
+            groupSyncRead->getError(id, &state->hardware_errors[id]);   // Only the alert bit is known
         }
     }
+    return dxl_comm_result;
+}
+
+Keyframe QuadMotorControl::gradual_transition(int* next_positions, int hold_ms) {
+    // The control thread times the move from the goal positions of the previous step
+    Keyframe keyframe{};
+    std::copy(next_positions, next_positions + NUM_MOTORS + 1, keyframe.positions);
+    keyframe.move_ms = KEYFRAME_TIME_OPTIMAL;
+    keyframe.hold_ms = hold_ms;
+    keyframe.profile = motion_profile_;
+    return keyframe;
 }
 
-void QuadMotorControl::gradual_transition(int* next_positions) {
-    const int step_size = 17;
-    float step_arr[NUM_MOTORS + 1] = {0};
-    int num_motors = NUM_MOTORS;
+void QuadMotorControl::initMotionProfile() {
+    std::string profile;
+    this->get_parameter("motion_profile", profile);
+    if (profile == "linear") {
+        motion_profile_ = ProfileType::LINEAR;
+    } else if (profile == "trapezoidal") {
+        motion_profile_ = ProfileType::TRAPEZOIDAL;
+    } else {
+        if (profile != "min_jerk") {
+            RCLCPP_WARN(this->get_logger(), "Unknown motion_profile '%s', using min_jerk", profile.c_str());
+        }
+        motion_profile_ = ProfileType::MIN_JERK;
+    }
 
-    int updated_positions[NUM_MOTORS + 1] = {0};
+    std::vector<double> max_velocity, max_acceleration;
+    this->get_parameter("joint_max_velocity_deg_s", max_velocity);
+    this->get_parameter("joint_max_acceleration_deg_s2", max_acceleration);
 
-    // Ensure present_positions is updated before starting the transition
-    update_present_positions();
-    
-    std::copy(std::begin(present_positions), std::end(present_positions), std::begin(updated_positions));
+    JointLimits limits[NUM_MOTORS + 1];
+    limits[0] = JointLimits{INFINITY, INFINITY};
+    for (int id = 1; id <= NUM_MOTORS; id++) {
+        double velocity = (max_velocity.size() == NUM_MOTORS) ? max_velocity[id - 1] : DEFAULT_MAX_VELOCITY_DEG_S;
+        double acceleration = (max_acceleration.size() == NUM_MOTORS) ? max_acceleration[id - 1] : DEFAULT_MAX_ACCELERATION_DEG_S2;
+        limits[id] = JointLimits{(float)(velocity * TICKS_PER_DEGREE), (float)(acceleration * TICKS_PER_DEGREE)};
+    }
+    if (max_velocity.size() != NUM_MOTORS || max_acceleration.size() != NUM_MOTORS) {
+        RCLCPP_WARN(this->get_logger(), "Joint limits need %d entries, using defaults where missing", NUM_MOTORS);
+    }
+    executor_.setLimits(limits);    // Before the control thread starts
+}
+
+bool QuadMotorControl::enqueueCommand(const MotorCommand& command) {
+    if (!command_queue_.push(command)) {
+        RCLCPP_WARN(this->get_logger(), "Control command queue full, dropping command");
+        return false;
+    }
+    return true;
+}
+
+bool QuadMotorControl::enqueueTrajectory(int config_id, const std::vector<Keyframe>& keyframes) {
+    if (keyframes.empty()) {
+        return false;
+    }
+    if (keyframes.size() > MAX_KEYFRAMES) {
+        RCLCPP_ERROR(this->get_logger(), "Config %d has %zu steps, more than %d", config_id, keyframes.size(), MAX_KEYFRAMES);
+        return false;
+    }
+    // All steps or none: the executor waits for num_steps keyframes before it finishes
+    if (command_queue_.available() < keyframes.size()) {
+        RCLCPP_WARN(this->get_logger(), "Control command queue full, dropping config %d", config_id);
+        return false;
+    }
 
-    for (int i = 1; i <= num_motors; i++) {
-        step_arr[i] = static_cast<float>(next_positions[i] - updated_positions[i]) / step_size;
+    MotorCommand command{};
+    command.type = MotorCommand::KEYFRAME;
+    command.trajectory_id = ++next_trajectory_id_;
+    command.config_id = config_id;
+    command.num_steps = keyframes.size();
+    MotionMode mode = servo_profile_enabled_ ? get_config_motion_mode(config_id) : MotionMode::HOST_INTERPOLATION;
+    for (const Keyframe& keyframe : keyframes) {
+        command.keyframe = keyframe;
+        command.keyframe.mode = mode;
+        command_queue_.push(command);   // Cannot fail: checked above, and only the control thread frees slots
     }
+    return true;
+}
+
+void QuadMotorControl::publishMotorState() {
+    MotorStateSnapshot state = state_snapshot_.load();
+    if (state.read_stamp_ns == last_published_state_ns_) {
+        return;  // No new read since the last message
+    }
+    last_published_state_ns_ = state.read_stamp_ns;
+    ScopedLatency probe(stageLatency(LoopStage::PUBLISH));
+
+    // Stamp with the ROS time of the read, not of this callback
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t age_ns = now.tv_sec * NSEC_PER_SEC + now.tv_nsec - state.read_stamp_ns;
 
-    for (int step = 0; step < step_size; step++) {
-        for (int i = 1; i <= num_motors; i++) {
-            updated_positions[i] += std::round(step_arr[i]);  // Fix rounding issue
+    auto message = quad_interfaces::msg::MotorState();
+    message.header.stamp = this->now() - rclcpp::Duration::from_nanoseconds(age_ns);
+    for (int id = 1; id <= NUM_MOTORS; id++) {
+        message.position[id - 1] = state.present_positions[id];
+        message.velocity[id - 1] = state.present_velocities[id];
+        message.current[id - 1] = state.present_currents[id];
+        message.input_voltage[id - 1] = state.input_voltages[id];
+        message.temperature[id - 1] = state.temperatures[id];
+        message.hardware_error[id - 1] = state.hardware_errors[id];
+    }
+    message.read_result = state.read_result;
+    message.read_latency_us = (uint32_t)(state.read_latency_ns / 1000);
+    motor_state_publisher_->publish(message);
+}
+
+void QuadMotorControl::publishTrajectoryProgress() {
+    TrajectoryProgress progress = progress_snapshot_.load();
+    if (progress.trajectory_id == last_published_progress_.trajectory_id &&
+        progress.status == last_published_progress_.status &&
+        progress.step == last_published_progress_.step &&
+        progress.step_fraction == last_published_progress_.step_fraction) {
+        return;
+    }
+
+    if (progress.status == TrajectoryProgress::PREEMPTED && last_published_progress_.status != TrajectoryProgress::PREEMPTED) {
+        RCLCPP_INFO(this->get_logger(), "Config %d preempted at step %d/%d", progress.config_id, progress.step + 1, progress.num_steps);
+    } else if (progress.status == TrajectoryProgress::DONE && last_published_progress_.status != TrajectoryProgress::DONE) {
+        RCLCPP_INFO(this->get_logger(), "Config %d done", progress.config_id);
+    }
+    last_published_progress_ = progress;
+
+    auto message = quad_interfaces::msg::TrajectoryProgress();
+    message.trajectory_id = progress.trajectory_id;
+    message.config_id = progress.config_id;
+    message.status = progress.status;
+    message.step = progress.step;
+    message.num_steps = progress.num_steps;
+    message.step_fraction = progress.step_fraction;
+    trajectory_progress_publisher_->publish(message);
+}
+
+void QuadMotorControl::publishLoopTiming() {
+    auto message = quad_interfaces::msg::LoopTiming();
+    message.header.stamp = this->now();
+
+    // Percentiles over this period only, so a regression is not averaged away by the history
+    LatencyHistogram::Snapshot snapshot;
+    for (int stage = 0; stage < static_cast<int>(LoopStage::COUNT); stage++) {
+        stage_latency_[stage].snapshot(&snapshot);
+        LatencyHistogram::Snapshot period = snapshot;
+        period.subtract(last_timing_[stage]);
+        last_timing_[stage] = snapshot;
+
+        message.stage.push_back(LOOP_STAGE_NAMES[stage]);
+        message.count.push_back(period.total);
+        message.mean_us.push_back(period.meanNs() / 1000.0);
+        message.p50_us.push_back(period.percentileNs(50.0) / 1000.0f);
+        message.p90_us.push_back(period.percentileNs(90.0) / 1000.0f);
+        message.p99_us.push_back(period.percentileNs(99.0) / 1000.0f);
+        message.p999_us.push_back(period.percentileNs(99.9) / 1000.0f);
+        message.max_us.push_back(period.maxNs() / 1000.0f);
+    }
+    message.overruns = overrun_count_.load(std::memory_order_relaxed);
+    loop_timing_publisher_->publish(message);
+}
+
+void QuadMotorControl::logLoopTiming() {
+    RCLCPP_INFO(this->get_logger(), "Loop timing since start (us), %lu control overruns:",
+        (unsigned long)overrun_count_.load(std::memory_order_relaxed));
+    RCLCPP_INFO(this->get_logger(), "%-15s %10s %9s %9s %9s %9s %9s %9s",
+        "stage", "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+
+    LatencyHistogram::Snapshot snapshot;
+    for (int stage = 0; stage < static_cast<int>(LoopStage::COUNT); stage++) {
+        stage_latency_[stage].snapshot(&snapshot);
+        RCLCPP_INFO(this->get_logger(), "%-15s %10lu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f",
+            LOOP_STAGE_NAMES[stage], (unsigned long)snapshot.total, snapshot.meanNs() / 1000.0,
+            snapshot.percentileNs(50.0) / 1000.0, snapshot.percentileNs(90.0) / 1000.0,
+            snapshot.percentileNs(99.0) / 1000.0, snapshot.percentileNs(99.9) / 1000.0,
+            snapshot.maxNs() / 1000.0);
+    }
+}
+
+bool QuadMotorControl::isMotionIdle() const {
+    return command_queue_.empty() && !trajectory_active_.load(std::memory_order_acquire);
+}
+
+void QuadMotorControl::startControlLoop() {
+    control_running_.store(true);
+    control_thread_ = std::thread(&QuadMotorControl::controlLoop, this);
+    RCLCPP_INFO(this->get_logger(), "Control thread started at %d Hz", control_rate_hz_);
+}
+
+void QuadMotorControl::stopControlLoop() {
+    control_running_.store(false);
+    if (control_thread_.joinable()) {
+        control_thread_.join();
+    }
+}
+
+void QuadMotorControl::startImuLoop() {
+    if (i2c_file < 0) {
+        return;  // No IMU: the roll check never sees a reading
+    }
+    imu_running_.store(true);
+    imu_thread_ = std::thread(&QuadMotorControl::imuLoop, this);
+    if (imu_fifo_active_) {
+        RCLCPP_INFO(this->get_logger(), "IMU thread started, draining %d samples at %d Hz", imu_fifo_watermark_, IMU_ODR_HZ);
+    } else {
+        RCLCPP_INFO(this->get_logger(), "IMU thread started at %d Hz", imu_rate_hz_);
+    }
+}
+
+void QuadMotorControl::stopImuLoop() {
+    imu_running_.store(false);
+    if (imu_thread_.joinable()) {
+        imu_thread_.join();
+    }
+}
+
+void QuadMotorControl::imuLoop() {
+    configureRealtime("IMU", imu_rt_priority_, -1);
+
+    // Polled: one sample per period. FIFO: one batch of imu_fifo_watermark samples per period.
+    const int64_t sample_period_ns = NSEC_PER_SEC / (imu_fifo_active_ ? IMU_ODR_HZ : imu_rate_hz_);
+    const int64_t period_ns = imu_fifo_active_ ? sample_period_ns * imu_fifo_watermark_ : sample_period_ns;
+    const float accel_z_offset = 0.2f / 9.81f;     // g
+    RollFilter filter((float)imu_filter_kp_, (float)imu_filter_ki_);
+    int64_t last_stamp_ns = 0;
+    ImuSample samples[IMU_FIFO_MAX_SAMPLES];
+    struct timespec next_wakeup;
+    clock_gettime(CLOCK_MONOTONIC, &next_wakeup);
+
+    while (imu_running_.load(std::memory_order_relaxed)) {
+        struct timespec start, stamp;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int count = imu_fifo_active_ ? drainImuFifo(samples, IMU_FIFO_MAX_SAMPLES)
+                                     : (readImuSample(&samples[0]) == 0 ? 1 : 0);
+        clock_gettime(CLOCK_MONOTONIC, &stamp);
+        int64_t read_ns = stamp.tv_sec * NSEC_PER_SEC + stamp.tv_nsec;
+        stageLatency(LoopStage::IMU_READ).record(read_ns - (start.tv_sec * NSEC_PER_SEC + start.tv_nsec));
+
+        for (int i = 0; i < count; i++) {
+            // The newest sample is stamped with the end of the read, older ones one ODR period apart
+            ImuReading reading;
+            reading.raw = samples[i];
+            reading.stamp_ns = std::max(read_ns - (count - 1 - i) * sample_period_ns, last_stamp_ns + 1);
+
+            // Fuse the gyro roll rate with the gravity direction
+            float dt = (last_stamp_ns > 0) ? (reading.stamp_ns - last_stamp_ns) * 1e-9f : 0.0f;
+            last_stamp_ns = reading.stamp_ns;
+            filter.update(reading.raw.gyro_x * IMU_GYRO_DPS_PER_LSB,
+                          reading.raw.accel_x * IMU_ACCEL_G_PER_LSB,
+                          reading.raw.accel_y * IMU_ACCEL_G_PER_LSB,
+                          reading.raw.accel_z * IMU_ACCEL_G_PER_LSB - accel_z_offset,
+                          1.0f, dt);
+            reading.tilt_deg = filter.rollDegrees();
+            reading.roll_rate_dps = filter.rateDps();
+            imu_ring_.push(reading);
+        }
+
+        next_wakeup.tv_nsec += period_ns;
+        while (next_wakeup.tv_nsec >= NSEC_PER_SEC) {
+            next_wakeup.tv_nsec -= NSEC_PER_SEC;
+            next_wakeup.tv_sec++;
+        }
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec > next_wakeup.tv_sec || (now.tv_sec == next_wakeup.tv_sec && now.tv_nsec > next_wakeup.tv_nsec)) {
+            next_wakeup = now;  // A slow I2C transfer: do not burst to catch up
+            continue;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_wakeup, nullptr);
+    }
+}
+
+void QuadMotorControl::configureRealtime(const char* thread_name, int priority, int cpu) {
+    // Keep the whole process resident so a page fault never stalls a tick
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        RCLCPP_WARN(this->get_logger(), "mlockall failed: %s", strerror(errno));
+    }
+
+    sched_param param{};
+    param.sched_priority = priority;
+    int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (result != 0) {
+        RCLCPP_WARN(this->get_logger(), "%s thread: SCHED_FIFO priority %d not granted (%s), running with normal priority",
+            thread_name, priority, strerror(result));
+    }
+
+    if (cpu >= 0) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(cpu, &cpu_set);
+        result = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+        if (result != 0) {
+            RCLCPP_WARN(this->get_logger(), "Failed to pin %s thread to CPU %d: %s", thread_name, cpu, strerror(result));
+        }
+    }
+}
+
+void QuadMotorControl::processCommands(int64_t now_ns) {
+    MotorCommand* command;
+    while ((command = command_queue_.front()) != nullptr) {
+        if (command->type == MotorCommand::SET_POSITION) {
+            executor_.cancel();         // A manual goal overrides the trajectory
+            goal_positions_[command->id] = command->position;
+            goals_dirty_ = true;
+        } else {
+            if (command->trajectory_id != executor_.progress().trajectory_id) {
+                if (!goals_initialized_) {      // No state read yet: start from the first step
+                    std::copy(command->keyframe.positions, command->keyframe.positions + NUM_MOTORS + 1, goal_positions_);
+                    goals_initialized_ = true;
+                }
+                executor_.cancel();
+                executor_.begin(command->trajectory_id, command->config_id, command->num_steps, now_ns, goal_positions_);
+                trajectory_active_.store(true, std::memory_order_release);  // Before pop(), so the node never looks idle
+            }
+            executor_.append(command->trajectory_id, command->keyframe);
         }
-        apply_motor_positions(updated_positions);
-        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        command_queue_.pop();
     }
+}
+
+void QuadMotorControl::controlLoop() {
+    configureRealtime("Control", rt_priority_, cpu_affinity_);
+
+    const int64_t period_ns = NSEC_PER_SEC / control_rate_hz_;
+    MotorStateSnapshot state{};
+    struct timespec next_wakeup;
+    clock_gettime(CLOCK_MONOTONIC, &next_wakeup);
+
+    while (control_running_.load(std::memory_order_relaxed)) {
+        struct timespec tick_start;
+        clock_gettime(CLOCK_MONOTONIC, &tick_start);
+        int64_t now_ns = tick_start.tv_sec * NSEC_PER_SEC + tick_start.tv_nsec;
+        stageLatency(LoopStage::CONTROL_JITTER).record(
+            now_ns - (next_wakeup.tv_sec * NSEC_PER_SEC + next_wakeup.tv_nsec));
+
+        processCommands(now_ns);
+
+        // Read state
+        state.read_result = readMotorState(&state);
+        std::copy(state.present_positions, state.present_positions + NUM_MOTORS + 1, present_positions);
+        if (!goals_initialized_ && state.read_result == COMM_SUCCESS) {
+            std::copy(present_positions, present_positions + NUM_MOTORS + 1, goal_positions_);
+            goals_initialized_ = true;
+        }
+
+        // Apply the active setpoint and write goals only when they changed
+        bool goals_changed = executor_.update(now_ns, goal_positions_) || goals_dirty_;
+        goals_dirty_ = false;
+        trajectory_active_.store(executor_.isRunning(), std::memory_order_release);
+
+        uint32_t accel_ms, duration_ms;
+        if (executor_.takeServoMove(&accel_ms, &duration_ms)) {
+            apply_servo_profile_move(goal_positions_, accel_ms, duration_ms);
+        } else if (goals_changed) {
+            if (servo_profile_active_) {
+                apply_servo_profile_move(goal_positions_, 0, 0);  // Back to immediate goals for host interpolation
+            } else {
+                apply_motor_positions(goal_positions_);
+            }
+        }
+        progress_snapshot_.store(executor_.progress());
+
+        std::copy(goal_positions_, goal_positions_ + NUM_MOTORS + 1, state.goal_positions);
+        state.tick = ++tick_count_;
+        state_snapshot_.store(state);
+
+        struct timespec tick_end;
+        clock_gettime(CLOCK_MONOTONIC, &tick_end);
+        stageLatency(LoopStage::CONTROL_TICK).record(tick_end.tv_sec * NSEC_PER_SEC + tick_end.tv_nsec - now_ns);
 
-    // Ensure we reach the exact target position
-    apply_motor_positions(next_positions);
+        // Sleep until the next period on an absolute clock so the rate does not drift
+        next_wakeup.tv_nsec += period_ns;
+        while (next_wakeup.tv_nsec >= NSEC_PER_SEC) {
+            next_wakeup.tv_nsec -= NSEC_PER_SEC;
+            next_wakeup.tv_sec++;
+        }
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t late_ns = (now.tv_sec - next_wakeup.tv_sec) * NSEC_PER_SEC + (now.tv_nsec - next_wakeup.tv_nsec);
+        if (late_ns > 0) {
+            // The tick overran its period: start the next one now instead of bursting to catch up
+            overrun_count_.fetch_add(1, std::memory_order_relaxed);
+            next_wakeup = now;
+            continue;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_wakeup, nullptr);
+    }
 }
 
+#ifndef QUAD_MOTOR_CONTROL_NO_MAIN  // Tests link the node without it
 int main(int argc, char * argv[]) {
     initialize_turning_configs_right();  // Ensure all arrays are set up
     initialize_relative_configs();
@@ -612,3 +1564,4 @@ int main(int argc, char * argv[]) {
     rclcpp::shutdown();
     return 0;
 }
+#endif
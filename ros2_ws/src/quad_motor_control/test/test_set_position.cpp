@@ -0,0 +1,62 @@
+// Runs the node against the virtual servo chain from c++/simulator
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "rclcpp/rclcpp.hpp"
+#include "quad_interfaces/msg/set_position.hpp"
+#include "dxl_simulator.h"
+
+// position_configs.hpp defines its tables in the header, so the node is compiled into this file
+#include "../src/quad_motor_control.cpp"
+
+using namespace std::chrono_literals;
+
+// Spins until done() holds or the timeout passes; returns done()
+template <typename Predicate>
+bool spinUntil(rclcpp::Executor& executor, Predicate done, std::chrono::milliseconds timeout)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!done() && std::chrono::steady_clock::now() < deadline) {
+        executor.spin_some(10ms);
+    }
+    return done();
+}
+
+TEST(SetPosition, IdleGoalIsWritten)
+{
+    SimOptions options;
+    options.model_wire_time = false;
+    DxlSimulator simulator(options);
+    ASSERT_TRUE(simulator.open(NULL));
+    ASSERT_TRUE(simulator.start());
+
+    std::string device_name = std::string("device_name:=") + simulator.getPortName();
+    const char* argv[] = {"test_set_position", "--ros-args", "-p", device_name.c_str()};
+    rclcpp::init(4, argv);
+    {
+        auto node = std::make_shared<QuadMotorControl>();
+        auto publisher_node = std::make_shared<rclcpp::Node>("set_position_publisher");
+        auto publisher = publisher_node->create_publisher<quad_interfaces::msg::SetPosition>("set_position", 10);
+        rclcpp::executors::SingleThreadedExecutor executor;
+        executor.add_node(node);
+        executor.add_node(publisher_node);
+        ASSERT_TRUE(spinUntil(executor, [&]() { return publisher->get_subscription_count() > 0; }, 5000ms));
+
+        // No trajectory is running, so once start-up is done nothing is written
+        spinUntil(executor, []() { return false; }, 500ms);
+        uint64_t idle_writes = simulator.getStats().sync_write_packets;
+        spinUntil(executor, []() { return false; }, 500ms);
+        EXPECT_EQ(simulator.getStats().sync_write_packets, idle_writes);
+
+        quad_interfaces::msg::SetPosition msg;
+        msg.id = 1;
+        msg.position = 2500;
+        publisher->publish(msg);
+        EXPECT_TRUE(spinUntil(executor, [&]() { return simulator.getStats().sync_write_packets > idle_writes; }, 2000ms));
+    }
+    rclcpp::shutdown();
+    simulator.stop();
+}